@@ -0,0 +1,393 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "hashset/LinearProbeHashSet.hpp"
+#include "hashset/ChainHashSet.hpp"
+
+#include "hash/md5.hpp"
+#include "hash/sha256.hpp"
+#include "hash/murmur3.hpp"
+#include "hash/fmix64.hpp"
+
+#include "bench/Workload.hpp"
+#include "bench/Tag.hpp"
+
+using namespace std;
+using namespace hashset;
+
+// same digests as md5hash, sha256hash and murmur3hash, but
+// the first 8 bytes are taken instead of the last ones,
+// to see whether the order matters for tables
+struct md5first {
+    size_t operator()(const string& str) const {
+        unsigned char result[MD5_DIGEST_LENGTH];
+        md5digest(str.data(), str.size(), result);
+        size_t h;
+        memcpy(&h, result, sizeof(h));
+        return h;
+    }
+};
+
+struct sha256first {
+    size_t operator()(const string& str) const {
+        unsigned char result[SHA256_DIGEST_LENGTH];
+        SHA256((unsigned char*)(str.data()), str.size(), result);
+        size_t h;
+        memcpy(&h, result, sizeof(h));
+        return h;
+    }
+};
+
+struct murmur3first {
+    size_t operator()(const string& str) const {
+        unsigned char result[16];
+        MurmurHash3_x64_128(str.data(), str.size(), 123, result);
+        size_t h;
+        memcpy(&h, result, sizeof(h));
+        return h;
+    }
+};
+
+// hashers as tables get them, with digest order variants
+template<class F>
+void string_hashers(F f, bool variants) {
+    f(bench::Tag<md5hash<string>>{}, "md5");
+    f(bench::Tag<sha256hash<string>>{}, "sha256");
+    f(bench::Tag<murmur3hash<string, 123>>{}, "murmur");
+    f(bench::Tag<std::hash<string>>{}, "std");
+    if (!variants) return;
+    f(bench::Tag<md5first>{}, "md5-first");
+    f(bench::Tag<sha256first>{}, "sha256-first");
+    f(bench::Tag<murmur3first>{}, "murmur-first");
+}
+
+template<class F>
+void int_hashers(F f) {
+    f(bench::Tag<md5hash<size_t>>{}, "md5");
+    f(bench::Tag<sha256hash<size_t>>{}, "sha256");
+    f(bench::Tag<murmur3hash<size_t, 123>>{}, "murmur");
+    f(bench::Tag<std::hash<size_t>>{}, "std");
+    f(bench::Tag<fmix64hash<size_t>>{}, "fmix64");
+}
+
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// keeps result alive without a store in the loop
+volatile size_t sink;
+
+struct Speed {
+    double ns;
+    double cycles;
+};
+
+// batched: independent keys, so hashes overlap in pipeline,
+// latency: next key depends on previous hash
+template<class Hash, typename K>
+Speed measure_speed(const vector<K>& keys, size_t rounds, bool latency) {
+    Hash hash;
+    const size_t mask = keys.size() - 1;
+    size_t acc = 0;
+
+    const auto start = chrono::steady_clock::now();
+    const uint64_t from = ticks();
+
+    if (latency) {
+        size_t id = 0;
+        for (size_t i = 0; i < rounds * keys.size(); ++i) {
+            acc += hash(keys[id]);
+            id = acc & mask;
+        }
+    } else {
+        for (size_t r = 0; r < rounds; ++r)
+            for (const auto& key: keys)
+                acc ^= hash(key);
+    }
+
+    const uint64_t to = ticks();
+    const auto finish = chrono::steady_clock::now();
+    sink = acc;
+
+    const double n = rounds * keys.size();
+    return {
+        chrono::duration<double, nano>(finish - start).count() / n,
+        (to - from) / n
+    };
+}
+
+// expected number of keys sharing a bucket with an
+// earlier one, if n keys go to m buckets at random
+double expected_collisions(size_t n, size_t m) {
+    return n - m * (1 - pow(1 - 1.0 / m, double(n)));
+}
+
+template<class Hash, typename K>
+size_t collisions(const vector<K>& keys, size_t m, bool masked) {
+    Hash hash;
+    vector<bool> used(m, false);
+    size_t count = 0;
+
+    for (const auto& key: keys) {
+        const size_t h = hash(key);
+        const size_t b = masked ? h & (m - 1) : h % m;
+        count += used[b];
+        used[b] = true;
+    }
+
+    return count;
+}
+
+// flips every bit of a key and looks at low 16 bits
+// of hash, these are the ones masked tables use,
+// returns max and mean deviation from 1/2
+template<typename K>
+K flip(const K& key, size_t bit);
+
+template<>
+string flip(const string& key, size_t bit) {
+    string res = key;
+    res[bit / 8] ^= char(1 << (bit % 8));
+    return res;
+}
+
+template<>
+size_t flip(const size_t& key, size_t bit) {
+    return key ^ (size_t(1) << bit);
+}
+
+template<class Hash, typename K>
+pair<double, double> avalanche(const vector<K>& keys, size_t bits) {
+    Hash hash;
+    const size_t out = 16;
+    vector<size_t> flips(bits * out, 0);
+
+    for (const auto& key: keys) {
+        const size_t h = hash(key);
+        for (size_t i = 0; i < bits; ++i) {
+            const size_t diff = h ^ hash(flip(key, i));
+            for (size_t j = 0; j < out; ++j)
+                flips[i * out + j] += (diff >> j) & 1;
+        }
+    }
+
+    double worst = 0, total = 0;
+    for (size_t f: flips) {
+        const double bias = fabs(double(f) / keys.size() - 0.5);
+        worst = max(worst, bias);
+        total += bias;
+    }
+
+    return {worst, total / flips.size()};
+}
+
+// named key sets the quality is checked on
+template<typename K>
+vector<pair<string, vector<K>>> key_sets(size_t n, const vector<string>& words);
+
+template<>
+vector<pair<string, vector<string>>> key_sets(size_t n, const vector<string>& words) {
+    mt19937_64 rg(0);
+    bench::WorkloadConfig cfg;
+    cfg.length = bench::LengthDist::UNIFORM;
+    cfg.min_len = 8;
+    cfg.max_len = 16;
+
+    vector<string> seq, prefixed, random;
+    for (size_t i = 0; i < n; ++i) {
+        seq.push_back(to_string(i));
+        prefixed.push_back("user:" + string(8 - min<size_t>(8, to_string(i).size()), '0') + to_string(i));
+    }
+    random = bench::KeyGen<string>::make(cfg, {}, n, rg);
+
+    vector<pair<string, vector<string>>> sets{
+        {"seq", seq}, {"prefixed", prefixed}, {"random", random}
+    };
+    if (!words.empty())
+        sets.emplace_back("words", bench::KeyGen<string>::make(cfg, words, n, rg));
+
+    return sets;
+}
+
+template<>
+vector<pair<string, vector<size_t>>> key_sets(size_t n, const vector<string>&) {
+    mt19937_64 rg(0);
+    vector<size_t> seq, strided, random;
+    for (size_t i = 0; i < n; ++i) {
+        seq.push_back(i);
+        strided.push_back(i << 12);
+    }
+    random = bench::KeyGen<size_t>::make({}, {}, n, rg);
+
+    return {{"seq", seq}, {"strided", strided}, {"random", random}};
+}
+
+template<typename K>
+size_t key_bits(const vector<K>& keys);
+
+template<>
+size_t key_bits(const vector<string>& keys) {
+    size_t len = keys.front().size();
+    for (const auto& key: keys) len = min(len, key.size());
+    return min<size_t>(len, 8) * 8;
+}
+
+template<>
+size_t key_bits(const vector<size_t>&) {
+    return 64;
+}
+
+template<typename K, class Hashers>
+void quality(const string& type, Hashers hashers, const vector<string>& words, ostream& res) {
+    const size_t n = 1 << 16;
+    const size_t pow2 = n;
+    // chain table sizes are not powers of 2
+    const size_t odd = n * 3 / 2;
+
+    for (const auto& [set_name, keys]: key_sets<K>(n, words)) {
+        const vector<K> sample(keys.begin(), keys.begin() + 2000);
+        const size_t bits = key_bits(sample);
+
+        hashers([&](auto tag, const string& name) {
+            using Hash = typename decltype(tag)::type;
+
+            const double mask_ratio =
+                collisions<Hash>(keys, pow2, true) / expected_collisions(n, pow2);
+            const double mod_ratio =
+                collisions<Hash>(keys, odd, false) / expected_collisions(n, odd);
+            const auto [worst, mean] = avalanche<Hash>(sample, bits);
+
+            // probes as linear probing and chaining really see them
+            LinearProbeHashSet<K, Hash> linear;
+            ChainHashSet<K, Hash> chain;
+            for (const auto& key: keys) {
+                linear.insert(key);
+                chain.insert(key);
+            }
+            const auto lstats = linear.stats();
+            const auto cstats = chain.stats();
+
+            // knuth, successful search in linear probing
+            const double alpha = lstats.load_factor;
+            const double ideal = 0.5 * (1 + 1 / (1 - alpha));
+
+            // 2000 samples give about 0.011 of noise in avalanche
+            const bool suspicious =
+                mask_ratio > 1.1 || mod_ratio > 1.1 ||
+                worst > 0.06 || lstats.mean_probe > ideal * 1.2;
+
+            res << type << "\t" << set_name << "\t" << name << "\t"
+                << mask_ratio << "\t" << mod_ratio << "\t"
+                << worst << "\t" << mean << "\t"
+                << lstats.mean_probe << "\t" << lstats.max_probe << "\t" << ideal << "\t"
+                << cstats.mean_probe << "\t" << cstats.max_probe << "\t"
+                << (suspicious ? "suspicious" : "ok") << endl;
+        });
+    }
+}
+
+void speed(ostream& res) {
+    mt19937_64 rg(0);
+    const size_t batch = 1024;
+
+    for (size_t len = 1; len <= 4096; len *= 2) {
+        bench::WorkloadConfig cfg;
+        cfg.length = bench::LengthDist::FIXED;
+        cfg.min_len = len;
+
+        vector<string> keys;
+        for (size_t i = 0; i < batch; ++i)
+            keys.push_back(bench::KeyGen<string>::synthetic(cfg, rg));
+
+        // about 4 mb hashed, but not too many short keys
+        const size_t rounds = clamp<size_t>((1 << 22) / (batch * len), 1, 64);
+
+        string_hashers([&](auto tag, const string& name) {
+            using Hash = typename decltype(tag)::type;
+
+            for (bool latency: {false, true}) {
+                const Speed s = measure_speed<Hash>(keys, rounds, latency);
+                res << "string\t" << name << "\t" << len << "\t"
+                    << (latency ? "latency" : "batched") << "\t"
+                    << s.ns << "\t" << s.cycles << "\t" << len / s.cycles << endl;
+            }
+        }, false);
+    }
+
+    const auto keys = bench::KeyGen<size_t>::make({}, {}, batch, rg);
+    int_hashers([&](auto tag, const string& name) {
+        using Hash = typename decltype(tag)::type;
+
+        for (bool latency: {false, true}) {
+            const Speed s = measure_speed<Hash>(keys, 64, latency);
+            res << "int\t" << name << "\t" << sizeof(size_t) << "\t"
+                << (latency ? "latency" : "batched") << "\t"
+                << s.ns << "\t" << s.cycles << "\t" << sizeof(size_t) / s.cycles << endl;
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    bool do_speed = false;
+    bool do_quality = false;
+    string pref = "data/";
+    vector<string> words;
+
+    for (int i = 1; i < argc; ++i) {
+        const string arg(argv[i]);
+        if (arg == "speed")
+            do_speed = true;
+        else if (arg == "quality")
+            do_quality = true;
+        else if (arg == "--output" && i + 1 < argc)
+            pref = string(argv[++i]) + "/";
+        else if (arg == "--words" && i + 1 < argc) {
+            ifstream in(argv[++i]);
+            for (string word; in >> word; )
+                words.push_back(word);
+        }
+        else {
+            cerr << "Usage: hash-bench [speed] [quality] "
+                    "[--output dir] [--words file]" << endl;
+            return 1;
+        }
+    }
+
+    if (!do_speed && !do_quality)
+        do_speed = do_quality = true;
+
+    if (do_speed) {
+        cout << "Measuring speed..." << endl;
+
+        ofstream res(pref + "hash_speed.csv", ofstream::out | ofstream::trunc);
+        res << "keys\thasher\tlength\tmode\tns\tcycles\tbytes_per_cycle" << endl;
+        speed(res);
+    }
+
+    if (do_quality) {
+        cout << "Measuring quality..." << endl;
+
+        ofstream res(pref + "hash_quality.csv", ofstream::out | ofstream::trunc);
+        res << "keys\tset\thasher\tmask_collisions\tmod_collisions\t"
+               "avalanche_max\tavalanche_mean\tlinear_probe\tlinear_max\t"
+               "linear_ideal\tchain_probe\tchain_max\tverdict" << endl;
+
+        quality<string>("string", [](auto f) { string_hashers(f, true); }, words, res);
+        quality<size_t>("int", [](auto f) { int_hashers(f); }, words, res);
+    }
+}
@@ -15,16 +15,24 @@
 #include "hashset/QuadraticProbeHashSet.hpp"
 #include "hashset/DoubleHashingHashSet.hpp"
 #include "hashset/CuckooHashSet.hpp"
+#include "hashset/HopscotchHashSet.hpp"
+#include "hashset/IntHashSet.hpp"
+#include "hashset/FilteredHashSet.hpp"
+#include "hashset/AdaptiveHashSet.hpp"
+#include "hashset/SharedHashSet.hpp"
 
 #include "hash/md5.hpp"
 #include "hash/sha256.hpp"
 #include "hash/murmur3.hpp"
+#include "hash/fmix64.hpp"
+
+#include "bench/Workload.hpp"
+#include "bench/Registry.hpp"
+#include "bench/Matrix.hpp"
 
 using namespace std;
 using namespace hashset;
 
-default_random_engine rg;
-
 vector<string> read_lines(istream& in) {
     vector<string> lines;
 
@@ -37,172 +45,94 @@ vector<string> read_lines(istream& in) {
     return lines;
 }
 
-pair<vector<string>, vector<string>> gen_data(
-    const vector<string>& source, const size_t n
-) {
-    vector<string> data;
-    sample(
-        source.begin(), source.end(), 
-        back_inserter(data), n * 3 / 2, rg
-    );
-
-    const size_t size = data.size();
-
-    vector<string> questions;
-    copy(data.begin(), data.begin() + size / 2, back_inserter(questions));
-    copy(data.begin() + size * 2 / 3, data.end(), back_inserter(questions));
-    shuffle(questions.begin(), questions.end(), rg);
-
-    data.resize(size * 2 / 3);
-
-    return {data, questions};
-}
-
-template<typename T, typename Set>
-void test(const vector<T>& source, size_t size, ostream& res) {
-    res << "size\tmean_time" << endl;
-    
-    discrete_distribution choice{0.1, 0.9};
-
-    for (size_t n = 10; n < size; n = n * 3 / 2) {
-        chrono::nanoseconds total(0);
-        
-        const size_t rounds = 10;
-        for (size_t round = 0; round < rounds; ++round) {
-            const auto& [sample, quests] = gen_data(source, n);
-
-            Set set;
-
-            auto start = chrono::high_resolution_clock::now();
-            for (const auto& elem: sample)
-                set.insert(elem);
-            
-            for (const auto& elem: quests)
-                if (choice(rg)) set.find(elem);
-                else set.remove(elem);
-            auto finish = chrono::high_resolution_clock::now();
-
-            total += chrono::duration_cast<chrono::nanoseconds>(finish - start);
-        }
-
-        const size_t mean = total.count() / (rounds * 2 * n);
-        res << n << "\t" << mean << endl;
+template<typename K>
+bench::Registry<K> make_registry() {
+    bench::Registry<K> reg;
+
+    auto hashers = [](auto f) {
+        f(bench::Tag<md5hash<K>>{}, "md5");
+        f(bench::Tag<sha256hash<K>>{}, "sha256");
+        f(bench::Tag<murmur3hash<K, 123>>{}, "murmur");
+        f(bench::Tag<std::hash<K>>{}, "std");
+    };
+
+    hashers([&](auto tag, const string& name) {
+        using Hash = typename decltype(tag)::type;
+
+        reg.template add<ChainHashSet<K, Hash>>("chain", name);
+        reg.template add<LinearProbeHashSet<K, Hash>>("linear", name);
+        reg.template add<QuadraticProbeHashSet<K, Hash>>("quadratic", name);
+        reg.template add<HopscotchHashSet<K, Hash>>("hopscotch", name);
+        reg.template add<HopscotchHashSet<K, Hash, 64>>("hopscotch64", name);
+        // second hash is std::hash unless asked for explicitly
+        reg.template add<DoubleHashingHashSet<K, Hash, std::hash<K>>>("doublehashing", name);
+        // load factor is chosen online
+        reg.template add<AdaptiveHashSet<K, Hash>, false>("adaptive", name);
+        // fixed capacity segment, string keys only
+        if constexpr (std::is_same_v<K, string>)
+            reg.template add<SharedHashSet<Hash>, false>("shared", name);
+
+        // negative lookups answered by a filter in front
+        reg.template add<FilteredHashSet<K, ChainHashSet<K, Hash>>>("chain+bloom", name);
+        reg.template add<FilteredHashSet<K, LinearProbeHashSet<K, Hash>>>("linear+bloom", name);
+        reg.template add<FilteredHashSet<K, ChainHashSet<K, Hash>, CuckooFilter>>("chain+cuckoofilter", name);
+        reg.template add<FilteredHashSet<K, LinearProbeHashSet<K, Hash>, CuckooFilter>>("linear+cuckoofilter", name);
+
+        hashers([&](auto tag2, const string& name2) {
+            using Hash2 = typename decltype(tag2)::type;
+            if (name == name2) return;
+
+            const string pair = name + "+" + name2;
+            reg.template add<DoubleHashingHashSet<K, Hash, Hash2>>("doublehashing", pair);
+            reg.template add<CuckooHashSet<K, Hash, Hash2>, false>("cuckoo", pair);
+            // first hash is fast one, second is switched to on long probes
+            reg.template add<AdaptiveHashSet<K, Hash, Hash2>, false>("adaptive", pair);
+        });
+    });
+
+    // raw 64 bit keys, only for integer mode
+    if constexpr (std::is_same_v<K, uint64_t>) {
+        reg.template add<IntHashSet<>>("int", "fmix64");
+        hashers([&](auto tag, const string& name) {
+            using Hash = typename decltype(tag)::type;
+            reg.template add<IntHashSet<Hash>>("int", name);
+        });
     }
+
+    return reg;
 }
 
 int main(int argc, char* argv[]) {
-    vector<string> words = read_lines(cin);
-
-    vector<string> data;
-    const size_t test_max = 1000000;
-    while (data.size() < test_max * 3 / 2) 
-        data.insert(data.end(), words.begin(), words.end());
-    
-    words.clear();
-
-    bool chain = false;
-    bool linear = false;
-    bool quadratic = false;
-    bool doublehashing = false;
-    bool cuckoo = false;
-
-    for (int i = 1; i < argc; ++i) {
-        if (string(argv[i]) == "chain")
-            chain = true;
-        else if (string(argv[i]) == "linear")
-            linear = true;
-        else if (string(argv[i]) == "quadratic")
-            quadratic = true;
-        else if (string(argv[i]) == "doublehashing")
-            doublehashing = true;
-        else if (string(argv[i]) == "cuckoo")
-            cuckoo = true;
-    }
-
-    string pref = "data/";
-
-    // chain
-    if (chain) {
-        cout << "Testing chain..." << endl;
-
-        ofstream chain_md5(pref + "chain_md5.csv", ofstream::out | ofstream::trunc);
-        test<string, ChainHashSet<string, md5hash<string>>>(data, test_max, chain_md5);
-        chain_md5.close();
-
-        ofstream chain_sha256(pref + "chain_sha256.csv", ofstream::out | ofstream::trunc);
-        test<string, ChainHashSet<string, sha256hash<string>>>(data, test_max, chain_sha256);
-        chain_sha256.close();
-
-        ofstream chain_murmur(pref + "chain_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, ChainHashSet<string, murmur3hash<string, 123>>>(data, test_max, chain_murmur);
-        chain_murmur.close();
-    }
-
-    // linear
-    if (linear) {
-        cout << "Testing linear..." << endl;
-
-        ofstream linear_md5(pref + "linear_md5.csv", ofstream::out | ofstream::trunc);
-        test<string, LinearProbeHashSet<string, md5hash<string>>>(data, test_max, linear_md5);
-        linear_md5.close();
-
-        ofstream linear_sha256(pref + "linear_sha256.csv", ofstream::out | ofstream::trunc);
-        test<string, LinearProbeHashSet<string, sha256hash<string>>>(data, test_max, linear_sha256);
-        linear_sha256.close();
-
-        ofstream linear_murmur(pref + "linear_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, LinearProbeHashSet<string, murmur3hash<string, 123>>>(data, test_max, linear_murmur);
-        linear_murmur.close();
-    }
-
-    // quadratic
-    if (quadratic) {
-        cout << "Testing quadratic..." << endl;
-
-        ofstream quadratic_md5(pref + "quadratic_md5.csv", ofstream::out | ofstream::trunc);
-        test<string, QuadraticProbeHashSet<string, md5hash<string>>>(data, test_max, quadratic_md5);
-        quadratic_md5.close();
-
-        ofstream quadratic_sha256(pref + "quadratic_sha256.csv", ofstream::out | ofstream::trunc);
-        test<string, QuadraticProbeHashSet<string, sha256hash<string>>>(data, test_max, quadratic_sha256);
-        quadratic_sha256.close();
-
-        ofstream quadratic_murmur(pref + "quadratic_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, QuadraticProbeHashSet<string, murmur3hash<string, 123>>>(data, test_max, quadratic_murmur);
-        quadratic_murmur.close();
-    }
-
-    // double
-    if (doublehashing) {
-        cout << "Testing doublehashing..." << endl;
-
-        ofstream double_md5(pref + "double_md5.csv", ofstream::out | ofstream::trunc);
-        test<string, DoubleHashingHashSet<string, md5hash<string>, std::hash<string>>>(data, test_max, double_md5);
-        double_md5.close();
-
-        ofstream double_sha256(pref + "double_sha256.csv", ofstream::out | ofstream::trunc);
-        test<string, DoubleHashingHashSet<string, sha256hash<string>, std::hash<string>>>(data, test_max, double_sha256);
-        double_sha256.close();
-
-        ofstream double_murmur(pref + "double_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, DoubleHashingHashSet<string, murmur3hash<string, 123>, std::hash<string>>>(data, test_max, double_murmur);
-        double_murmur.close();
-    }
-
-    // cuckoo
-    if (cuckoo) {
-        cout << "Testing cuckoo..." << endl;
-
-        ofstream cuckoo_md5_sha256(pref + "cuckoo_md5_sha256.csv", ofstream::out | ofstream::trunc);
-        test<string, CuckooHashSet<string, md5hash<string>, sha256hash<string>>>(data, test_max, cuckoo_md5_sha256);
-        cuckoo_md5_sha256.close();
+    try {
+        // keys, format and workloads are validated here
+        const bench::MatrixConfig cfg = bench::parse_args(argc, argv);
+
+        const auto key_types = bench::split(cfg.keys, ',');
+        const bool strings =
+            std::find(key_types.begin(), key_types.end(), "string") != key_types.end();
+
+        // words are only needed for string keys
+        vector<string> words;
+        if (!strings || cfg.words.empty()) {}
+        else if (cfg.words == "-")
+            words = read_lines(cin);
+        else {
+            ifstream in(cfg.words);
+            if (!in)
+                throw std::runtime_error("Can't open words: " + cfg.words);
+            words = read_lines(in);
+        }
 
-        ofstream cuckoo_md5_murmur(pref + "cuckoo_md5_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, CuckooHashSet<string, md5hash<string>, murmur3hash<string, 123>>>(data, test_max, cuckoo_md5_murmur);
-        cuckoo_md5_murmur.close();
+        bench::Writer writer(cfg.output, cfg.format);
 
-        ofstream cuckoo_sha256_murmur(pref + "cuckoo_sha256_murmur.csv", ofstream::out | ofstream::trunc);
-        test<string, CuckooHashSet<string, sha256hash<string>, murmur3hash<string, 123>>>(data, test_max, cuckoo_sha256_murmur);
-        cuckoo_sha256_murmur.close();
+        for (const auto& keys: key_types) {
+            if (keys == "string")
+                bench::run_matrix(cfg, make_registry<string>(), words, writer, keys);
+            else
+                bench::run_matrix(cfg, make_registry<size_t>(), {}, writer, keys);
+        }
+    } catch (const std::exception& e) {
+        cerr << e.what() << endl;
+        return 1;
     }
 }
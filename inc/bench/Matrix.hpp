@@ -0,0 +1,495 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <limits>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "Workload.hpp"
+#include "Registry.hpp"
+#include "PerfCounters.hpp"
+
+namespace bench {
+
+using std::string;
+using std::vector;
+using std::pair;
+
+// everything benchmark is going to enumerate,
+// filled from config file and command line
+struct MatrixConfig {
+    vector<string> sets;
+    vector<string> hashers{
+        "md5", "sha256", "murmur",
+        "md5+sha256", "md5+murmur", "sha256+murmur"
+    };
+    vector<double> factors{0.75};
+    vector<string> workloads{"uniform"};
+    vector<size_t> sizes;
+
+    // measured operations per preloaded key
+    double ops = 1.25;
+    size_t repeats = 10;
+    size_t warmup = 1;
+    uint64_t seed = 0;
+    // negative means do not pin
+    int cpu = 0;
+    // read hardware counters around every phase
+    bool counters = false;
+
+    string keys = "string";
+    // file with words, "-" is stdin, empty is synthetic keys
+    string words = "-";
+    string output = "data/results.csv";
+    string format = "csv";
+};
+
+inline vector<string> split(const string& str, char sep) {
+    vector<string> parts;
+    std::stringstream in(str);
+    for (string part; std::getline(in, part, sep); )
+        if (!part.empty()) parts.push_back(part);
+    return parts;
+}
+
+inline string trim(const string& str) {
+    const auto first = str.find_first_not_of(" \t\r");
+    if (first == string::npos) return "";
+    const auto last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+// sizes are either a list or a geometric range from:to:scale
+inline vector<size_t> parse_sizes(const string& value) {
+    const auto range = split(value, ':');
+    if (range.size() == 3) {
+        const size_t to = std::stoull(range[1]);
+        const double scale = std::stod(range[2]);
+        if (scale <= 1)
+            throw std::invalid_argument("Size scale should be above 1");
+
+        vector<size_t> sizes;
+        for (size_t n = std::stoull(range[0]); n < to;
+             n = std::max<size_t>(n * scale, n + 1))
+            sizes.push_back(n);
+        return sizes;
+    }
+
+    vector<size_t> sizes;
+    for (const auto& size: split(value, ','))
+        sizes.push_back(std::stoull(size));
+    return sizes;
+}
+
+inline void set_option(MatrixConfig& cfg, const string& key, const string& value) {
+    auto doubles = [](const string& value) {
+        vector<double> res;
+        for (const auto& v: split(value, ','))
+            res.push_back(std::stod(v));
+        return res;
+    };
+
+    if (key == "sets") cfg.sets = split(value, ',');
+    else if (key == "hashers") cfg.hashers = split(value, ',');
+    else if (key == "factors") cfg.factors = doubles(value);
+    else if (key == "workloads") cfg.workloads = split(value, ',');
+    else if (key == "sizes") cfg.sizes = parse_sizes(value);
+    else if (key == "ops") cfg.ops = std::stod(value);
+    else if (key == "repeats") cfg.repeats = std::stoull(value);
+    else if (key == "warmup") cfg.warmup = std::stoull(value);
+    else if (key == "seed") cfg.seed = std::stoull(value);
+    else if (key == "cpu") cfg.cpu = std::stoi(value);
+    else if (key == "counters") cfg.counters = value == "on" || value == "1" || value == "true";
+    else if (key == "keys") cfg.keys = value;
+    else if (key == "words") cfg.words = value;
+    else if (key == "output") cfg.output = value;
+    else if (key == "format") cfg.format = value;
+    else throw std::invalid_argument("Unknown option: " + key);
+}
+
+// lines of "key = value", # starts a comment
+inline void read_config(MatrixConfig& cfg, std::istream& in) {
+    for (string line; std::getline(in, line); ) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        const auto eq = line.find('=');
+        if (eq == string::npos)
+            throw std::invalid_argument("Bad config line: " + line);
+
+        set_option(cfg, trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+    }
+}
+
+// preset[:key=value...], for example zipf:theta=1.2:hit=0.3
+inline WorkloadConfig parse_workload(const string& spec) {
+    const auto parts = split(spec, ':');
+    if (parts.empty())
+        throw std::invalid_argument("Empty workload");
+
+    WorkloadConfig cfg;
+    const string& preset = parts[0];
+
+    if (preset == "uniform") {}
+    else if (preset == "zipf") cfg.dist = KeyDist::ZIPF;
+    else if (preset == "hotspot") cfg.dist = KeyDist::HOTSPOT;
+    else if (preset == "mixed") {
+        cfg.insert_ratio = 0.2;
+        cfg.find_ratio = 0.7;
+        cfg.remove_ratio = 0.1;
+    }
+    else if (preset == "churn") {
+        cfg.insert_ratio = 0.45;
+        cfg.find_ratio = 0.1;
+        cfg.remove_ratio = 0.45;
+    }
+    else if (preset == "readonly") {
+        cfg.find_ratio = 1;
+        cfg.remove_ratio = 0;
+    }
+    else if (preset == "missheavy") cfg.hit_ratio = 0.1;
+    else throw std::invalid_argument("Unknown workload: " + preset);
+
+    for (size_t i = 1; i < parts.size(); ++i) {
+        const auto eq = parts[i].find('=');
+        if (eq == string::npos)
+            throw std::invalid_argument("Bad workload parameter: " + parts[i]);
+
+        const string key = parts[i].substr(0, eq);
+        const string value = parts[i].substr(eq + 1);
+
+        if (key == "insert") cfg.insert_ratio = std::stod(value);
+        else if (key == "find") cfg.find_ratio = std::stod(value);
+        else if (key == "remove") cfg.remove_ratio = std::stod(value);
+        else if (key == "hit") cfg.hit_ratio = std::stod(value);
+        else if (key == "theta") cfg.zipf_theta = std::stod(value);
+        else if (key == "hot") cfg.hot_fraction = std::stod(value);
+        else if (key == "hotp") cfg.hot_probability = std::stod(value);
+        else if (key == "minlen") cfg.min_len = std::stoull(value);
+        else if (key == "maxlen") cfg.max_len = std::stoull(value);
+        else if (key == "meanlen") cfg.mean_len = std::stod(value);
+        else if (key == "length") {
+            if (value == "fixed") cfg.length = LengthDist::FIXED;
+            else if (value == "uniform") cfg.length = LengthDist::UNIFORM;
+            else if (value == "lognormal") cfg.length = LengthDist::LOGNORMAL;
+            else throw std::invalid_argument("Unknown length: " + value);
+        }
+        else throw std::invalid_argument("Unknown workload parameter: " + key);
+    }
+
+    return cfg;
+}
+
+// --key=value, --key value and --config file,
+// bare words are set names as it used to be
+inline MatrixConfig parse_args(int argc, char* argv[]) {
+    MatrixConfig cfg;
+    vector<string> sets;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        if (arg.rfind("--", 0) != 0) {
+            sets.push_back(arg);
+            continue;
+        }
+
+        arg = arg.substr(2);
+        string value;
+        const auto eq = arg.find('=');
+        if (eq != string::npos) {
+            value = arg.substr(eq + 1);
+            arg = arg.substr(0, eq);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            throw std::invalid_argument("No value for option: " + arg);
+        }
+
+        if (arg == "config") {
+            std::ifstream in(value);
+            if (!in)
+                throw std::invalid_argument("Can't open config: " + value);
+            read_config(cfg, in);
+        } else {
+            set_option(cfg, arg, value);
+        }
+    }
+
+    if (!sets.empty()) cfg.sets = sets;
+    if (cfg.sizes.empty()) cfg.sizes = parse_sizes("10:1000000:1.5");
+    if (cfg.repeats == 0)
+        throw std::invalid_argument("At least one repeat is needed");
+
+    // everything is checked before the first run starts
+    if (cfg.format != "csv" && cfg.format != "json")
+        throw std::invalid_argument("Unknown format: " + cfg.format);
+    for (const auto& spec: cfg.workloads)
+        parse_workload(spec);
+    if (split(cfg.keys, ',').empty())
+        throw std::invalid_argument("No keys given");
+    for (const auto& keys: split(cfg.keys, ','))
+        if (keys != "string" && keys != "int")
+            throw std::invalid_argument("Unknown keys: " + keys);
+
+    return cfg;
+}
+
+// keeps measurements on one cpu, so that
+// caches and frequency do not jump around
+inline bool pin_thread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) return true;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return cpu < 0;
+#endif
+}
+
+struct Summary {
+    double mean;
+    double stddev;
+    // half-width of 95% confidence interval
+    double ci95;
+    double min;
+    double max;
+};
+
+// two-sided 95% student quantile
+inline double student95(size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df == 0) return std::numeric_limits<double>::quiet_NaN();
+    if (df <= 30) return table[df - 1];
+    return 1.960;
+}
+
+inline Summary summarize(const vector<double>& xs) {
+    const size_t n = xs.size();
+
+    double mean = 0;
+    for (double x: xs) mean += x;
+    mean /= n;
+
+    double var = 0;
+    for (double x: xs) var += (x - mean) * (x - mean);
+    const double stddev = n > 1 ? std::sqrt(var / (n - 1)) : 0;
+
+    return {
+        mean, stddev,
+        n > 1 ? student95(n - 1) * stddev / std::sqrt(double(n)) : 0,
+        *std::min_element(xs.begin(), xs.end()),
+        *std::max_element(xs.begin(), xs.end())
+    };
+}
+
+// one row of tidy result table
+struct Row {
+    string keys;
+    string set;
+    string hasher;
+    string workload;
+    double factor;
+    size_t size;
+    string phase;
+    size_t ops;
+    size_t repeats;
+    // nanoseconds per operation
+    Summary time;
+    // mean hardware events per operation
+    Counts counts;
+};
+
+class Writer {
+    std::ofstream out;
+    const bool json;
+    bool first = true;
+
+public:
+    // format is checked before output is truncated
+    Writer(const string& path, const string& format) : json(format == "json") {
+        if (format != "csv" && format != "json")
+            throw std::invalid_argument("Unknown format: " + format);
+
+        out.open(path, std::ofstream::out | std::ofstream::trunc);
+        if (!out)
+            throw std::runtime_error("Can't open output: " + path);
+
+        if (json) {
+            out << "[" << std::endl;
+            return;
+        }
+
+        out << "keys\tset\thasher\tworkload\tfactor\tsize\tphase\tops\t"
+               "repeats\tmean_time\tstddev\tci95\tmin_time\tmax_time";
+        for (size_t i = 0; i < COUNTERS; ++i)
+            out << "\t" << counter_name(i);
+        out << std::endl;
+    }
+
+    ~Writer() {
+        if (json) out << std::endl << "]" << std::endl;
+    }
+
+    void write(const Row& row) {
+        if (json) {
+            // nan is not valid json
+            auto num = [](double x) {
+                return std::isnan(x) ? string("null") : std::to_string(x);
+            };
+
+            if (!first) out << "," << std::endl;
+            out << "  {\"keys\": \"" << row.keys
+                << "\", \"set\": \"" << row.set
+                << "\", \"hasher\": \"" << row.hasher
+                << "\", \"workload\": \"" << row.workload
+                << "\", \"factor\": " << num(row.factor)
+                << ", \"size\": " << row.size
+                << ", \"phase\": \"" << row.phase
+                << "\", \"ops\": " << row.ops
+                << ", \"repeats\": " << row.repeats
+                << ", \"mean_time\": " << num(row.time.mean)
+                << ", \"stddev\": " << num(row.time.stddev)
+                << ", \"ci95\": " << num(row.time.ci95)
+                << ", \"min_time\": " << num(row.time.min)
+                << ", \"max_time\": " << num(row.time.max);
+            for (size_t i = 0; i < COUNTERS; ++i)
+                out << ", \"" << counter_name(i) << "\": " << num(row.counts[i]);
+            out << "}";
+        } else {
+            out << row.keys << "\t" << row.set << "\t" << row.hasher << "\t"
+                << row.workload << "\t" << row.factor << "\t" << row.size << "\t"
+                << row.phase << "\t" << row.ops << "\t" << row.repeats << "\t"
+                << row.time.mean << "\t" << row.time.stddev << "\t"
+                << row.time.ci95 << "\t" << row.time.min << "\t"
+                << row.time.max;
+            for (double count: row.counts)
+                out << "\t" << count;
+            out << std::endl;
+        }
+
+        first = false;
+    }
+};
+
+template<typename T>
+bool selected(const MatrixConfig& cfg, const typename Registry<T>::Entry& entry) {
+    auto has = [](const vector<string>& list, const string& name) {
+        return std::find(list.begin(), list.end(), name) != list.end();
+    };
+
+    return (cfg.sets.empty() || has(cfg.sets, entry.set)) &&
+           has(cfg.hashers, entry.hasher);
+}
+
+// workloads x sizes x sets x hashers x factors,
+// every repeat shares one generated workload
+// between all entries, so they are compared fairly
+template<typename T>
+void run_matrix(
+    const MatrixConfig& cfg, const Registry<T>& registry,
+    const vector<T>& source, Writer& writer, const string& keys
+) {
+    if (!pin_thread(cfg.cpu))
+        std::cerr << "Failed to pin to cpu " << cfg.cpu << std::endl;
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    // entry and factor to run it with
+    vector<pair<const typename Registry<T>::Entry*, double>> runs;
+    for (const auto& entry: registry.entries()) {
+        if (!selected<T>(cfg, entry)) continue;
+
+        if (entry.factor)
+            for (double factor: cfg.factors)
+                runs.emplace_back(&entry, factor);
+        else runs.emplace_back(&entry, nan);
+    }
+
+    if (runs.empty())
+        std::cerr << "Nothing to run for " << keys << " keys" << std::endl;
+
+    PerfCounters perf(cfg.counters);
+    if (cfg.counters && !perf.available())
+        std::cerr << "Hardware counters are not available" << std::endl;
+
+    // mean of counts per operation over repeats
+    auto average = [](const vector<Counts>& samples) {
+        Counts mean{};
+        for (const auto& counts: samples)
+            for (size_t i = 0; i < COUNTERS; ++i)
+                mean[i] += counts[i] / samples.size();
+        return mean;
+    };
+
+    auto per_op = [](Counts counts, size_t ops) {
+        for (auto& count: counts) count /= std::max<size_t>(ops, 1);
+        return counts;
+    };
+
+    for (const auto& spec: cfg.workloads) {
+        WorkloadConfig wcfg = parse_workload(spec);
+
+        for (const size_t size: cfg.sizes) {
+            std::cout << keys << " " << spec << " " << size << std::endl;
+
+            wcfg.preload = size;
+            wcfg.ops = std::llround(size * cfg.ops);
+
+            vector<vector<double>> preload(runs.size()), replay(runs.size());
+            vector<vector<Counts>> preload_counts(runs.size()), replay_counts(runs.size());
+
+            for (size_t rep = 0; rep < cfg.repeats; ++rep) {
+                wcfg.seed = cfg.seed * cfg.repeats + rep;
+                const auto wl = generate(wcfg, source);
+
+                for (size_t i = 0; i < runs.size(); ++i) {
+                    const auto& [entry, factor] = runs[i];
+
+                    if (rep == 0)
+                        for (size_t w = 0; w < cfg.warmup; ++w)
+                            entry->run(wl, factor, perf);
+
+                    const Sample sample = entry->run(wl, factor, perf);
+                    preload[i].push_back(sample.preload_ns / std::max<size_t>(wl.preload.size(), 1));
+                    replay[i].push_back(sample.replay_ns / std::max<size_t>(wl.ops.size(), 1));
+                    preload_counts[i].push_back(per_op(sample.preload_counts, wl.preload.size()));
+                    replay_counts[i].push_back(per_op(sample.replay_counts, wl.ops.size()));
+                }
+            }
+
+            for (size_t i = 0; i < runs.size(); ++i) {
+                const auto& [entry, factor] = runs[i];
+                Row row{
+                    keys, entry->set, entry->hasher, spec, factor, size,
+                    "preload", wcfg.preload, cfg.repeats,
+                    summarize(preload[i]), average(preload_counts[i])
+                };
+                writer.write(row);
+
+                row.phase = "replay";
+                row.ops = wcfg.ops;
+                row.time = summarize(replay[i]);
+                row.counts = average(replay_counts[i]);
+                writer.write(row);
+            }
+        }
+    }
+}
+
+} // namespace bench
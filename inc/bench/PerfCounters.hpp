@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace bench {
+
+using std::array;
+
+enum Counter {
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    DTLB_MISSES,
+    BRANCH_MISSES,
+    COUNTERS
+};
+
+inline const char* counter_name(size_t counter) {
+    static const char* names[COUNTERS] = {
+        "cycles", "instructions", "l1d_misses",
+        "llc_misses", "dtlb_misses", "branch_misses"
+    };
+    return names[counter];
+}
+
+// nan means counter is not available
+using Counts = array<double, COUNTERS>;
+
+inline Counts no_counts() {
+    Counts counts;
+    counts.fill(std::numeric_limits<double>::quiet_NaN());
+    return counts;
+}
+
+// hardware counters of the calling thread around some code,
+// every counter is opened separately, so that the ones
+// kernel or hardware refuses just stay unavailable
+class PerfCounters {
+    array<int, COUNTERS> fds;
+
+#ifdef __linux__
+    static int open_counter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // counters could be multiplexed, so scale them
+        attr.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    static constexpr uint64_t cache_miss(uint64_t cache) {
+        return cache |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+public:
+    PerfCounters(bool enable=true) {
+        fds.fill(-1);
+        if (!enable) return;
+
+#ifdef __linux__
+        fds[CYCLES] = open_counter(
+            PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[INSTRUCTIONS] = open_counter(
+            PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[L1D_MISSES] = open_counter(
+            PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D));
+        fds[LLC_MISSES] = open_counter(
+            PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL));
+        fds[DTLB_MISSES] = open_counter(
+            PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB));
+        fds[BRANCH_MISSES] = open_counter(
+            PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd: fds)
+            if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool available() const {
+        for (int fd: fds)
+            if (fd >= 0) return true;
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd: fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Counts stop() {
+        Counts counts = no_counts();
+
+#ifdef __linux__
+        for (int fd: fds)
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        for (size_t i = 0; i < COUNTERS; ++i) {
+            if (fds[i] < 0) continue;
+
+            // value, time enabled, time running
+            uint64_t data[3];
+            if (read(fds[i], data, sizeof(data)) != sizeof(data) || !data[2])
+                continue;
+
+            counts[i] = double(data[0]) * data[1] / data[2];
+        }
+#endif
+
+        return counts;
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+#include "Workload.hpp"
+#include "PerfCounters.hpp"
+#include "Tag.hpp"
+
+namespace bench {
+
+using std::string;
+using std::vector;
+using std::function;
+
+// time and counters of both phases of one workload run
+struct Sample {
+    double preload_ns;
+    double replay_ns;
+    Counts preload_counts;
+    Counts replay_counts;
+    size_t success;
+};
+
+template<typename Set, typename T>
+Sample measure(Set& set, const Workload<T>& wl, PerfCounters& perf) {
+    using clock = std::chrono::steady_clock;
+
+    perf.start();
+    auto start = clock::now();
+    preload(set, wl);
+    auto middle = clock::now();
+    const Counts preload_counts = perf.stop();
+
+    perf.start();
+    auto resume = clock::now();
+    const size_t success = replay(set, wl);
+    auto finish = clock::now();
+    const Counts replay_counts = perf.stop();
+
+    return {
+        std::chrono::duration<double, std::nano>(middle - start).count(),
+        std::chrono::duration<double, std::nano>(finish - resume).count(),
+        preload_counts, replay_counts, success
+    };
+}
+
+// all set and hasher combinations benchmark
+// could be asked for, sets are called directly
+// not through IHashSet
+template<typename T>
+class Registry {
+public:
+    struct Entry {
+        string set;
+        string hasher;
+        // whether set is constructed from load factor
+        bool factor;
+        function<Sample(const Workload<T>&, double, PerfCounters&)> run;
+    };
+
+private:
+    vector<Entry> list;
+
+public:
+    template<class Set, bool factor=true>
+    void add(const string& set, const string& hasher) {
+        list.push_back({set, hasher, factor,
+            [](const Workload<T>& wl, double f, PerfCounters& perf) {
+                if constexpr (factor) {
+                    Set s(f);
+                    return measure(s, wl, perf);
+                } else {
+                    Set s;
+                    return measure(s, wl, perf);
+                }
+            }
+        });
+    }
+
+    const vector<Entry>& entries() const {
+        return list;
+    }
+};
+
+} // namespace bench
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace bench {
+
+// carries a type through generic lambdas
+template<typename T>
+struct Tag {
+    using type = T;
+};
+
+} // namespace bench
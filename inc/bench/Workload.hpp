@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <unordered_set>
+#include <stdexcept>
+
+namespace bench {
+
+using std::string;
+using std::vector;
+
+// how popular every key of the universe is
+enum class KeyDist {
+    UNIFORM,
+    ZIPF,       // rank k is chosen with probability ~ 1 / k^theta
+    HOTSPOT     // hot_fraction of keys gets hot_probability of accesses
+};
+
+// length of synthetic string keys
+enum class LengthDist {
+    FIXED,      // always min_len
+    UNIFORM,    // uniform in [min_len, max_len]
+    LOGNORMAL   // around mean_len, clamped to [min_len, max_len]
+};
+
+struct WorkloadConfig {
+    uint64_t seed = 0;
+
+    // keys inserted before measured operations
+    size_t preload = 1000;
+    // number of measured operations
+    size_t ops = 1000;
+
+    // operation mix, normalized on generation
+    double insert_ratio = 0.0;
+    double find_ratio = 0.9;
+    double remove_ratio = 0.1;
+
+    // share of find/remove targeting keys present in set
+    double hit_ratio = 0.6;
+
+    KeyDist dist = KeyDist::UNIFORM;
+    double zipf_theta = 0.99;
+    double hot_fraction = 0.1;
+    double hot_probability = 0.9;
+
+    LengthDist length = LengthDist::LOGNORMAL;
+    size_t min_len = 1;
+    size_t max_len = 32;
+    double mean_len = 8;
+};
+
+enum class OpType : uint8_t {
+    INSERT,
+    FIND,
+    REMOVE
+};
+
+struct Op {
+    OpType type;
+    // index into Workload::keys
+    uint32_t key;
+};
+
+template<typename T>
+struct Workload {
+    vector<T> keys;
+    vector<uint32_t> preload;
+    vector<Op> ops;
+};
+
+// samples ranks in [0, n) with probability ~ 1 / (rank + 1)^theta
+class ZipfDistribution {
+    vector<double> cdf;
+public:
+    ZipfDistribution(size_t n, double theta) : cdf(n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i)
+            cdf[i] = sum += 1.0 / std::pow(double(i + 1), theta);
+        for (auto& p: cdf) p /= sum;
+    }
+
+    template<class Rng>
+    size_t operator()(Rng& rg) const {
+        const double u = std::uniform_real_distribution<double>{}(rg);
+        auto it = std::lower_bound(cdf.begin(), cdf.end(), u);
+        return std::min<size_t>(it - cdf.begin(), cdf.size() - 1);
+    }
+};
+
+// produces n distinct keys of type T
+template<typename T>
+struct KeyGen;
+
+template<>
+struct KeyGen<string> {
+    // keys are taken from source first (deduplicated),
+    // then padded with source-derived or synthetic keys
+    template<class Rng>
+    static vector<string> make(
+        const WorkloadConfig& cfg, const vector<string>& source,
+        size_t n, Rng& rg
+    ) {
+        std::unordered_set<string> seen;
+        vector<string> keys;
+        keys.reserve(n);
+
+        vector<string> pool(source);
+        std::shuffle(pool.begin(), pool.end(), rg);
+        for (auto& word: pool) {
+            if (keys.size() == n) break;
+            if (seen.insert(word).second)
+                keys.emplace_back(std::move(word));
+        }
+
+        // keep length profile of source if there is one
+        const size_t base = keys.size();
+        for (size_t i = 0; keys.size() < n; ++i) {
+            string key = base ?
+                keys[i % base] + "#" + std::to_string(i / base) :
+                synthetic(cfg, rg);
+            // short lengths allow few distinct synthetic keys, so
+            // a repeated one gets a suffix no other key can have
+            if (!base && seen.count(key))
+                key += "#" + std::to_string(i);
+            if (seen.insert(key).second)
+                keys.emplace_back(std::move(key));
+        }
+
+        return keys;
+    }
+
+    template<class Rng>
+    static string synthetic(const WorkloadConfig& cfg, Rng& rg) {
+        static const char alphabet[] =
+            "abcdefghijklmnopqrstuvwxyz"
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+            "0123456789";
+
+        const size_t lo = std::max<size_t>(cfg.min_len, 1);
+        const size_t hi = std::max(cfg.max_len, lo);
+
+        size_t len = lo;
+        switch (cfg.length) {
+        case LengthDist::FIXED:
+            break;
+        case LengthDist::UNIFORM:
+            len = std::uniform_int_distribution<size_t>{lo, hi}(rg);
+            break;
+        case LengthDist::LOGNORMAL: {
+            std::lognormal_distribution<double> d{
+                std::log(std::max(cfg.mean_len, 1.0)), 0.5
+            };
+            len = std::clamp<size_t>(std::lround(d(rg)), lo, hi);
+            break;
+        }
+        }
+
+        std::uniform_int_distribution<size_t> ch{0, sizeof(alphabet) - 2};
+        string key(len, ' ');
+        for (auto& c: key) c = alphabet[ch(rg)];
+
+        return key;
+    }
+};
+
+template<>
+struct KeyGen<size_t> {
+    // source is ignored, integer keys are always random
+    template<class Rng>
+    static vector<size_t> make(
+        const WorkloadConfig&, const vector<size_t>&,
+        size_t n, Rng& rg
+    ) {
+        std::unordered_set<size_t> seen;
+        vector<size_t> keys;
+        keys.reserve(n);
+
+        while (keys.size() < n) {
+            const size_t key = rg();
+            if (seen.insert(key).second)
+                keys.push_back(key);
+        }
+
+        return keys;
+    }
+};
+
+// same config and seed always give the same workload
+template<typename T>
+Workload<T> generate(const WorkloadConfig& cfg, const vector<T>& source = {}) {
+    std::mt19937_64 rg(cfg.seed);
+
+    const double total = cfg.insert_ratio + cfg.find_ratio + cfg.remove_ratio;
+    if (total <= 0)
+        throw std::invalid_argument("Workload has no operations");
+
+    const size_t inserts = std::ceil(cfg.ops * cfg.insert_ratio / total);
+    // keys that are never inserted unless
+    // removes free space, needed for misses
+    const size_t misses = std::max<size_t>(cfg.preload / 2, 16);
+    const size_t universe = cfg.preload + inserts + misses;
+
+    if (universe > UINT32_MAX)
+        throw std::invalid_argument("Workload is too large");
+
+    Workload<T> wl;
+    wl.keys = KeyGen<T>::make(cfg, source, universe, rg);
+    wl.ops.reserve(cfg.ops);
+
+    // keys are already in random order, so popularity
+    // rank is just an index in keys
+    ZipfDistribution zipf(
+        cfg.dist == KeyDist::ZIPF ? universe : 0, cfg.zipf_theta
+    );
+    const size_t hot = std::clamp<size_t>(
+        universe * cfg.hot_fraction, 1, universe
+    );
+
+    auto popular = [&]() -> uint32_t {
+        switch (cfg.dist) {
+        case KeyDist::ZIPF:
+            return zipf(rg);
+        case KeyDist::HOTSPOT:
+            if (std::bernoulli_distribution{cfg.hot_probability}(rg) ||
+                hot == universe)
+                return std::uniform_int_distribution<size_t>{0, hot - 1}(rg);
+            return std::uniform_int_distribution<size_t>{hot, universe - 1}(rg);
+        default:
+            return std::uniform_int_distribution<size_t>{0, universe - 1}(rg);
+        }
+    };
+
+    // present and absent keys, pos is an index
+    // of key in the list it currently belongs to
+    vector<uint32_t> lists[2];
+    vector<uint32_t> pos(universe);
+    vector<bool> present(universe, false);
+
+    // popular keys are too slow to enumerate exactly,
+    // so a few rejections and then a uniform fallback
+    auto pick = [&](bool want) -> uint32_t {
+        for (int tries = 0; tries < 8; ++tries) {
+            const uint32_t key = popular();
+            if (present[key] == want) return key;
+        }
+        const auto& list = lists[want];
+        return list[std::uniform_int_distribution<size_t>{0, list.size() - 1}(rg)];
+    };
+
+    auto transfer = [&](uint32_t key, bool to) {
+        auto& from = lists[!to];
+        const uint32_t last = from.back();
+        from[pos[key]] = last;
+        pos[last] = pos[key];
+        from.pop_back();
+
+        pos[key] = lists[to].size();
+        lists[to].push_back(key);
+        present[key] = to;
+    };
+
+    for (uint32_t key = 0; key < universe; ++key) {
+        pos[key] = lists[false].size();
+        lists[false].push_back(key);
+    }
+
+    wl.preload.reserve(cfg.preload);
+    for (size_t i = 0; i < cfg.preload; ++i) {
+        const uint32_t key = pick(false);
+        transfer(key, true);
+        wl.preload.push_back(key);
+    }
+
+    std::discrete_distribution<int> choice{
+        cfg.insert_ratio, cfg.find_ratio, cfg.remove_ratio
+    };
+    std::bernoulli_distribution hit{cfg.hit_ratio};
+
+    for (size_t i = 0; i < cfg.ops; ++i) {
+        const OpType type = OpType(choice(rg));
+
+        bool want = type != OpType::INSERT && hit(rg);
+        if (lists[want].empty()) want = !want;
+
+        const uint32_t key = pick(want);
+        if (type == OpType::INSERT && !want) transfer(key, true);
+        if (type == OpType::REMOVE && want) transfer(key, false);
+
+        wl.ops.push_back({type, key});
+    }
+
+    return wl;
+}
+
+template<typename T, typename Set>
+void preload(Set& set, const Workload<T>& wl) {
+    for (const uint32_t key: wl.preload)
+        set.insert(wl.keys[key]);
+}
+
+// returns number of successful operations,
+// so that nothing could be optimized out
+template<typename T, typename Set>
+size_t replay(Set& set, const Workload<T>& wl) {
+    size_t success = 0;
+    for (const Op& op: wl.ops) {
+        const T& key = wl.keys[op.key];
+        switch (op.type) {
+        case OpType::INSERT: success += set.insert(key); break;
+        case OpType::FIND: success += set.find(key); break;
+        case OpType::REMOVE: success += set.remove(key); break;
+        }
+    }
+
+    return success;
+}
+
+} // namespace bench
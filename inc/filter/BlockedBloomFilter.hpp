@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace hashset {
+
+using std::vector;
+
+// split block bloom filter: key sets one bit in each
+// of 8 words of a single 32 byte block, so check is
+// one cache line access and one 256 bit test,
+// bits could not be removed, removed keys are only
+// counted as stale and filter should be rebuilt
+class BlockedBloomFilter {
+    struct alignas(32) Block {
+        uint32_t words[8];
+    };
+
+    static constexpr size_t bits_per_key = 12;
+
+    vector<Block> blocks;
+    size_t capacity;
+    size_t count;
+    size_t stale;
+
+    static constexpr uint32_t salt[8] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    // table uses low bits of the very same hash,
+    // so mix it before taking block from high bits
+    static inline uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    inline Block& block(uint64_t h) {
+        return blocks[((h >> 32) * blocks.size()) >> 32];
+    }
+
+    inline const Block& block(uint64_t h) const {
+        return blocks[((h >> 32) * blocks.size()) >> 32];
+    }
+
+#ifdef __AVX2__
+    static inline __m256i mask(uint32_t key) {
+        const __m256i salts = _mm256_setr_epi32(
+            salt[0], salt[1], salt[2], salt[3],
+            salt[4], salt[5], salt[6], salt[7]
+        );
+        __m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32(key), salts);
+        bits = _mm256_srli_epi32(bits, 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+    }
+#endif
+
+public:
+    BlockedBloomFilter(size_t capacity=1024) :
+        blocks(std::max<size_t>(capacity * bits_per_key / 256, 1)),
+        capacity(capacity), count(0), stale(0) {}
+
+    void insert(size_t hash) {
+        const uint64_t h = mix(hash);
+        Block& b = block(h);
+
+#ifdef __AVX2__
+        __m256i* words = reinterpret_cast<__m256i*>(b.words);
+        _mm256_store_si256(words, _mm256_or_si256(
+            _mm256_load_si256(words), mask(uint32_t(h))
+        ));
+#else
+        for (size_t i = 0; i < 8; ++i)
+            b.words[i] |= 1U << ((uint32_t(h) * salt[i]) >> 27);
+#endif
+
+        ++count;
+    }
+
+    bool contains(size_t hash) const {
+        const uint64_t h = mix(hash);
+        const Block& b = block(h);
+
+#ifdef __AVX2__
+        const __m256i words = _mm256_load_si256(
+            reinterpret_cast<const __m256i*>(b.words)
+        );
+        return _mm256_testc_si256(words, mask(uint32_t(h)));
+#else
+        for (size_t i = 0; i < 8; ++i)
+            if (!(b.words[i] & (1U << ((uint32_t(h) * salt[i]) >> 27))))
+                return false;
+        return true;
+#endif
+    }
+
+    void remove(size_t) {
+        ++stale;
+    }
+
+    // stale keys still occupy bits, so
+    // they are counted against capacity
+    bool full() const {
+        return count > capacity;
+    }
+
+    size_t bytes() const {
+        return blocks.size() * sizeof(Block);
+    }
+};
+
+} // namespace hashset
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace hashset {
+
+using std::vector;
+
+// cuckoo filter with buckets of four 16 bit fingerprints,
+// bucket is a single word, so it is checked at once,
+// alternative bucket is derived from fingerprint only
+class CuckooFilter {
+    static constexpr size_t max_kicks = 500;
+    static constexpr uint64_t lanes = 0x0001000100010001ULL;
+    static constexpr uint64_t highs = 0x8000800080008000ULL;
+
+    vector<uint64_t> buckets;
+    size_t mask;
+    size_t capacity;
+    size_t count;
+
+    // fingerprint that did not fit, filter is full then
+    uint16_t victim;
+    size_t victim_bucket;
+    // even victim did not fit, every key is maybe there
+    bool overflow;
+
+    static inline uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static inline uint16_t fingerprint(uint64_t h) {
+        const uint16_t fp = h >> 48;
+        // zero is an empty slot
+        return fp ? fp : 1;
+    }
+
+    inline size_t alt(size_t bucket, uint16_t fp) const {
+        return (bucket ^ (fp * 0x5bd1e995U)) & mask;
+    }
+
+    static inline uint16_t slot(uint64_t bucket, size_t i) {
+        return bucket >> (16 * i);
+    }
+
+    static inline void set_slot(uint64_t& bucket, size_t i, uint16_t fp) {
+        bucket &= ~(0xffffULL << (16 * i));
+        bucket |= uint64_t(fp) << (16 * i);
+    }
+
+    // swar check for a lane equal to fp
+    static inline bool has(uint64_t bucket, uint16_t fp) {
+        const uint64_t x = bucket ^ (lanes * fp);
+        return (x - lanes) & ~x & highs;
+    }
+
+    bool put(size_t bucket, uint16_t fp) {
+        uint64_t& b = buckets[bucket];
+        for (size_t i = 0; i < 4; ++i) {
+            if (!slot(b, i)) {
+                set_slot(b, i, fp);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool erase(size_t bucket, uint16_t fp) {
+        uint64_t& b = buckets[bucket];
+        for (size_t i = 0; i < 4; ++i) {
+            if (slot(b, i) == fp) {
+                set_slot(b, i, 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    // buckets are kept at most 95% full
+    CuckooFilter(size_t capacity=1024) :
+        capacity(capacity), count(0), victim(0), victim_bucket(0), overflow(false) {
+        size_t n = 1;
+        while (n * 4 * 95 < capacity * 100) n *= 2;
+
+        buckets.assign(n, 0);
+        mask = n - 1;
+    }
+
+    void insert(size_t hash) {
+        const uint64_t h = mix(hash);
+        uint16_t fp = fingerprint(h);
+        const size_t i1 = h & mask;
+        const size_t i2 = alt(i1, fp);
+
+        ++count;
+        if (put(i1, fp) || put(i2, fp)) return;
+
+        if (victim) {
+            overflow = true;
+            return;
+        }
+
+        size_t bucket = (h >> 32) & 1 ? i1 : i2;
+        for (size_t kick = 0; kick < max_kicks; ++kick) {
+            uint64_t& b = buckets[bucket];
+            const size_t i = (kick + fp) & 3;
+
+            const uint16_t out = slot(b, i);
+            set_slot(b, i, fp);
+            fp = out;
+
+            bucket = alt(bucket, fp);
+            if (put(bucket, fp)) return;
+        }
+
+        victim = fp;
+        victim_bucket = bucket;
+    }
+
+    bool contains(size_t hash) const {
+        if (overflow) return true;
+
+        const uint64_t h = mix(hash);
+        const uint16_t fp = fingerprint(h);
+        const size_t i1 = h & mask;
+        const size_t i2 = alt(i1, fp);
+
+        if (has(buckets[i1], fp) || has(buckets[i2], fp))
+            return true;
+
+        return victim == fp &&
+            (victim_bucket == i1 || victim_bucket == i2);
+    }
+
+    // hash should belong to a key inserted before
+    void remove(size_t hash) {
+        const uint64_t h = mix(hash);
+        const uint16_t fp = fingerprint(h);
+        const size_t i1 = h & mask;
+        const size_t i2 = alt(i1, fp);
+
+        --count;
+        if (victim == fp && (victim_bucket == i1 || victim_bucket == i2)) {
+            victim = 0;
+            return;
+        }
+
+        if (!erase(i1, fp)) erase(i2, fp);
+    }
+
+    // victim means inserts could not fit anymore
+    bool full() const {
+        return victim || count > capacity;
+    }
+
+    size_t bytes() const {
+        return buckets.size() * sizeof(uint64_t);
+    }
+};
+
+} // namespace hashset
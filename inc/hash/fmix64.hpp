@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// murmur3 finalizer, it is a bijection on 64 bit
+// integers, so it costs a few multiplies and never
+// makes collisions out of distinct keys
+template<typename T>
+struct fmix64hash;
+
+template<>
+struct fmix64hash<size_t> {
+    size_t operator()(const size_t& val) const {
+        uint64_t k = val;
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+
+        return k;
+    }
+};
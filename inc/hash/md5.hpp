@@ -4,6 +4,15 @@
 
 #include <openssl/md5.h>
 
+// MD5 is deprecated since OpenSSL 3.0, but it is
+// one of the hashes compared, so warning is silenced
+inline void md5digest(const void* data, size_t size, unsigned char* result) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    MD5((const unsigned char*)data, size, result);
+#pragma GCC diagnostic pop
+}
+
 template<typename T>
 struct md5hash;
 
@@ -11,7 +20,7 @@ template<>
 struct md5hash<std::string> {
     size_t operator()(const std::string& str) const {
         unsigned char result[MD5_DIGEST_LENGTH];
-        MD5((unsigned char*)(str.data()), str.size(), result);
+        md5digest(str.data(), str.size(), result);
         // Maybe I mixed order here...
         return *(size_t*)(result + sizeof(result) - sizeof(size_t));
     }
@@ -19,9 +28,9 @@ struct md5hash<std::string> {
 
 template<>
 struct md5hash<size_t> {
-    size_t operator()(const size_t& val) {
+    size_t operator()(const size_t& val) const {
         unsigned char result[MD5_DIGEST_LENGTH];
-        MD5((unsigned char*)(&val), sizeof(size_t), result);
+        md5digest(&val, sizeof(size_t), result);
         // Maybe I mixed order here...
         return *(size_t*)(result + sizeof(result) - sizeof(size_t));
     }
@@ -1,3 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
 //-----------------------------------------------------------------------------
 // MurmurHash3 was written by Austin Appleby, and is placed in the public
 // domain. The author hereby disclaims copyright to this source code.
@@ -66,7 +71,7 @@ static FORCE_INLINE uint64_t fmix64 ( uint64_t k )
 
 //-----------------------------------------------------------------------------
 
-void MurmurHash3_x64_128 ( const void * key, const int len,
+inline void MurmurHash3_x64_128 ( const void * key, const int len,
                            const uint32_t seed, void * out )
 {
     const uint8_t * data = (const uint8_t*)key;
@@ -163,7 +168,7 @@ struct murmur3hash<std::string, seed> {
 
 template<uint32_t seed>
 struct murmur3hash<size_t, seed> {
-    size_t operator()(const size_t& val) {
+    size_t operator()(const size_t& val) const {
         unsigned char result[16];
         MurmurHash3_x64_128(
             (unsigned char*)(&val), sizeof(size_t), seed, result
@@ -19,7 +19,7 @@ struct sha256hash<std::string> {
 
 template<>
 struct sha256hash<size_t> {
-    size_t operator()(const size_t& val) {
+    size_t operator()(const size_t& val) const {
         unsigned char result[SHA256_DIGEST_LENGTH];
         SHA256((unsigned char*)(&val), sizeof(size_t), result);
         // Maybe I mixed order here...
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <algorithm>
+
+#include "IHashSet.hpp"
+#include "../hash/fmix64.hpp"
+
+namespace hashset {
+
+using std::vector;
+using std::optional;
+using std::nullopt;
+
+enum class AdaptiveMode {
+    // tiny linear probing table at low load
+    SMALL,
+    // linear probing with tombstones, load factor is tuned
+    OPEN,
+    // two choice cuckoo over buckets of 4 slots at high load
+    BUCKETIZED
+};
+
+// set that watches its own probe lengths, miss ratio,
+// size and churn and at every resize migrates to the
+// layout, load factor and hasher that fit them best,
+// fast hasher is used until it gives too long probes,
+// both are mixed with murmur3 finalizer, so even
+// identity hash of integers spreads over slots
+template<typename T, class Fast=std::hash<T>, class Strong=Fast>
+class AdaptiveHashSet : public IHashSet<T> {
+    static constexpr size_t small_limit = 64;
+    static constexpr size_t large_limit = 1 << 16;
+    static constexpr size_t ways = 4;
+    static constexpr size_t max_kicks = 256;
+    // doublings before cuckoo is given up for good
+    static constexpr size_t max_grows = 3;
+    static constexpr size_t npos = size_t(-1);
+
+    // what happened since last migration
+    struct Observed {
+        Counter finds;
+        Counter misses;
+        Counter probes;
+        Counter inserts;
+        Counter removes;
+        Counter failures;
+
+        void reset() {
+            *this = Observed();
+        }
+    };
+
+    Fast fast;
+    Strong strong;
+
+    AdaptiveMode current;
+    bool strong_hash;
+    // false once keys could not be placed by cuckoo
+    bool cuckoo;
+    double factor;
+
+    vector<optional<T>> slots;
+    vector<bool> tombs;
+    size_t mask;
+
+    size_t live;
+    size_t populated;
+    // lengths[i] is number of keys found with i + 1
+    // probes, kept so stats never rehash keys
+    vector<size_t> lengths;
+
+    mutable Observed seen;
+    RehashStats rehashes;
+    HotStats hot;
+
+    inline size_t hash(const T& val) const {
+        return fmix64hash<size_t>{}(strong_hash ? strong(val) : fast(val));
+    }
+
+    // both buckets of bucketized mode, mask is over buckets
+    inline std::pair<size_t, size_t> buckets(size_t h) const {
+        return {h & mask, (h >> 32) & mask};
+    }
+
+    // slot of val or npos, probes are counted
+    size_t locate(const T& val, size_t& probes) const {
+        const size_t h = hash(val);
+
+        if (current == AdaptiveMode::BUCKETIZED) {
+            const auto [b1, b2] = buckets(h);
+            for (const size_t b: {b1, b2}) {
+                ++probes;
+                for (size_t i = b * ways; i < (b + 1) * ways; ++i)
+                    if (slots[i] == val) return i;
+            }
+            return npos;
+        }
+
+        for (size_t i = 0, id = h & mask; i < slots.size(); ++i, id = (id + 1) & mask) {
+            ++probes;
+            if (slots[id]) {
+                if (slots[id].value() == val) return id;
+            } else if (!tombs[id]) {
+                break;
+            }
+        }
+
+        return npos;
+    }
+
+    inline void count(size_t length, int delta) {
+        if (lengths.size() < length)
+            lengths.resize(length, 0);
+        lengths[length - 1] += delta;
+    }
+
+    // returns key that did not fit, if any
+    optional<T> place(T&& val) {
+        if (current != AdaptiveMode::BUCKETIZED) {
+            const size_t from = hash(val) & mask;
+            size_t id = from;
+            while (slots[id]) id = (id + 1) & mask;
+
+            if (!tombs[id]) ++populated;
+            tombs[id] = false;
+            slots[id] = std::move(val);
+            count(((id - from) & mask) + 1, 1);
+
+            return nullopt;
+        }
+
+        T carry = std::move(val);
+        size_t h = hash(carry);
+        size_t b = buckets(h).first;
+
+        for (size_t kick = 0; kick < max_kicks; ++kick) {
+            const auto [b1, b2] = buckets(h);
+            for (const size_t c: {b1, b2}) {
+                for (size_t i = c * ways; i < (c + 1) * ways; ++i) {
+                    if (!slots[i]) {
+                        slots[i] = std::move(carry);
+                        ++populated;
+                        count(c == b1 ? 1 : 2, 1);
+                        return nullopt;
+                    }
+                }
+            }
+
+            // evict someone from the bucket we did not come from
+            b = b == b1 ? b2 : b1;
+            const size_t i = b * ways + kick % ways;
+            std::swap(carry, slots[i].value());
+            count(b == b1 ? 1 : 2, 1);
+            HASHSET_COUNT(++hot.displacements);
+
+            h = hash(carry);
+            count(b == buckets(h).first ? 1 : 2, -1);
+        }
+
+        ++seen.failures;
+        return carry;
+    }
+
+    // mean linear probing probes at load a, knuth
+    static double expected_probes(double a, double miss) {
+        const double hit = 0.5 * (1 + 1 / (1 - a));
+        const double no = 0.5 * (1 + 1 / ((1 - a) * (1 - a)));
+        return (1 - miss) * hit + miss * no;
+    }
+
+    void choose(size_t n) {
+        const double finds = std::max<size_t>(seen.finds, 1);
+        const double miss = seen.misses / finds;
+        const double churn = double(seen.removes) / std::max<size_t>(seen.inserts, 1);
+
+        // too long probes mean fast hash does not suit these keys
+        if (!strong_hash && current != AdaptiveMode::BUCKETIZED &&
+            seen.finds >= 64 &&
+            seen.probes / finds > 2 * expected_probes(factor, miss) + 1)
+            strong_hash = true;
+
+        // cuckoo failing far from full load is the same sign
+        if (!strong_hash && seen.failures &&
+            populated < slots.size() / 2)
+            strong_hash = true;
+
+        if (n <= small_limit) {
+            current = AdaptiveMode::SMALL;
+            factor = 0.5;
+        } else if (cuckoo && (n >= large_limit || (miss > 0.5 && n >= small_limit * 16))) {
+            // misses cost two buckets at most, and there
+            // are no tombstones, so memory is saved
+            current = AdaptiveMode::BUCKETIZED;
+            factor = 0.9;
+        } else {
+            // misses and tombstones both lengthen runs
+            current = AdaptiveMode::OPEN;
+            factor = 0.8;
+            if (miss > 0.3) factor -= 0.15;
+            if (churn > 0.3) factor -= 0.1;
+        }
+    }
+
+    // moves all keys to the layout chosen for want keys
+    void migrate(size_t want, optional<T> extra=nullopt) {
+        auto scope = rehashes.scope();
+
+        vector<T> keys;
+        keys.reserve(live + 1);
+        for (auto& slot: slots)
+            if (slot) keys.push_back(std::move(slot.value()));
+        if (extra) keys.push_back(std::move(extra.value()));
+
+        choose(want);
+
+        size_t capacity = 8;
+        while (capacity * factor < want) capacity *= 2;
+        const size_t first = capacity;
+
+        for (;;) {
+            slots.clear();
+            slots.resize(capacity);
+            tombs.assign(capacity, false);
+            mask = current == AdaptiveMode::BUCKETIZED ?
+                capacity / ways - 1 : capacity - 1;
+            populated = 0;
+            lengths.clear();
+
+            vector<T> failed;
+            for (auto& key: keys) {
+                if (!failed.empty()) {
+                    failed.push_back(std::move(key));
+                    continue;
+                }
+                if (auto left = place(std::move(key)))
+                    failed.push_back(std::move(left.value()));
+            }
+
+            if (failed.empty()) break;
+
+            keys = std::move(failed);
+            for (auto& slot: slots)
+                if (slot) keys.push_back(std::move(slot.value()));
+
+            // more than 2 * ways keys with one full hash never
+            // fit, so cuckoo gives way to linear probing
+            capacity *= 2;
+            if (capacity > first << max_grows) {
+                cuckoo = false;
+                current = AdaptiveMode::OPEN;
+                factor = 0.8;
+
+                capacity = 8;
+                while (capacity * factor < want) capacity *= 2;
+            }
+        }
+
+        seen.reset();
+    }
+
+public:
+    using hasher = Fast;
+
+    AdaptiveHashSet() :
+        current(AdaptiveMode::SMALL), strong_hash(false), cuckoo(true), factor(0.5),
+        slots(8), tombs(8, false), mask(7), live(0), populated(0) {}
+
+    // load factor is chosen by the set itself
+    AdaptiveHashSet(double) : AdaptiveHashSet() {}
+
+    virtual bool insert(const T& val) override {
+        size_t probes = 0;
+        if (locate(val, probes) != npos)
+            return false;
+
+        ++seen.inserts;
+        if (populated + 1 > slots.size() * factor)
+            migrate(live + 1);
+
+        if (auto left = place(T(val)))
+            migrate(live + 1, std::move(left));
+
+        ++live;
+
+        return true;
+    }
+
+    virtual bool find(const T& val) const override {
+        HASHSET_COUNT(++hot.lookups);
+
+        size_t probes = 0;
+        const bool found = locate(val, probes) != npos;
+        HASHSET_COUNT(hot.probes += probes);
+
+        ++seen.finds;
+        seen.misses += !found;
+        seen.probes += probes;
+
+        return found;
+    }
+
+    virtual bool remove(const T& val) override {
+        size_t probes = 0;
+        const size_t id = locate(val, probes);
+        if (id == npos)
+            return false;
+
+        slots[id] = nullopt;
+        // probes of a found key are its length
+        count(probes, -1);
+        // bucketized slots are free right away
+        if (current == AdaptiveMode::BUCKETIZED) --populated;
+        else tombs[id] = true;
+
+        --live;
+        ++seen.removes;
+
+        return true;
+    }
+
+    AdaptiveMode mode() const {
+        return current;
+    }
+
+    bool strengthened() const {
+        return strong_hash;
+    }
+
+    double load_factor() const {
+        return factor;
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    // probe length is number of slots or buckets looked at
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = slots.size();
+        // bucketized mode leaves no tombstones
+        stats.tombstones = populated - live;
+
+        stats.histogram = lengths;
+        while (!stats.histogram.empty() && !stats.histogram.back())
+            stats.histogram.pop_back();
+        stats.max_probe = stats.histogram.size();
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+
+        return stats.finish();
+    }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(slots.size(), part, parts);
+        for (size_t id = from; id < to; ++id)
+            if (slots[id]) f(slots[id].value());
+    }
+};
+
+} // namespace hashset
@@ -18,24 +18,26 @@ class ChainHashSet : public IHashSet<T> {
     vector<list<T>> array;
     
     const double factor;
-    size_t size;
+    size_t live;
 
-    inline list<T>& get_chain(const T& val) {
-        size_t h = hash(val);
+    RehashStats rehashes;
+    HotStats hot;
+
+    inline list<T>& get_chain(size_t h) {
         return array.at(h % array.size());
     }
 
-    inline const list<T>& get_chain(const T& val) const {
-        size_t h = hash(val);
+    inline const list<T>& get_chain(size_t h) const {
         return array.at(h % array.size());
     }
 
     inline void rehash() {
-        if (size < array.size() * factor) return;
+        if (live < array.size() * factor) return;
+        auto scope = rehashes.scope();
 
         vector<list<T>> elems = std::move(array);
-        array.clear(); array.resize(size * scale);
-        size = 0;
+        array.clear(); array.resize(live * scale);
+        live = 0;
         
         for (auto& chain: elems)
             for (auto& elem: chain)
@@ -44,19 +46,26 @@ class ChainHashSet : public IHashSet<T> {
         elems.clear();
     }
 public:
+    using hasher = Hash;
+
     ChainHashSet(double factor=0.75) : 
-    factor(factor), size(0), array(16) {}
+    factor(factor), live(0), array(16) {}
 
     virtual bool insert(const T& val) override {
+        return insert(val, hash(val));
+    }
+
+    // h is hash of val, so wrappers hash key once
+    bool insert(const T& val, size_t h) {
         rehash();
 
-        list<T>& chain = get_chain(val);
+        list<T>& chain = get_chain(h);
         auto it = std::find(chain.begin(), chain.end(), val);
         
         if (it != chain.end()) return false;
         
         chain.push_front(val);
-        ++size;
+        ++live;
 
         return true;
     }
@@ -64,35 +73,76 @@ public:
     bool emplace(T&& val) {
         rehash();
 
-        list<T>& chain = get_chain(val);
+        list<T>& chain = get_chain(hash(val));
         auto it = std::find(chain.begin(), chain.end(), val);
         
         if (it != chain.end()) return false;
         
         chain.emplace_front(std::move(val));
-        ++size;
+        ++live;
 
         return true;
     }
 
     virtual bool find(const T& val) const override {
-        const list<T>& chain = get_chain(val);
+        return find(val, hash(val));
+    }
+
+    bool find(const T& val, size_t h) const {
+        HASHSET_COUNT(++hot.lookups);
+
+        const list<T>& chain = get_chain(h);
         auto it = std::find(chain.begin(), chain.end(), val);
+        HASHSET_COUNT(hot.probes += std::distance(chain.begin(), it) + 1);
         
         return it != chain.end();
     }
 
     virtual bool remove(const T& val) override {
-        list<T>& chain = get_chain(val);
+        return remove(val, hash(val));
+    }
+
+    bool remove(const T& val, size_t h) {
+        list<T>& chain = get_chain(h);
         auto it = std::find(chain.begin(), chain.end(), val);
 
         if (it == chain.end()) return false;
 
         chain.erase(it);
-        --size;
+        --live;
 
         return true;
     }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(array.size(), part, parts);
+        for (size_t id = from; id < to; ++id)
+            for (const auto& elem: array[id])
+                f(elem);
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = array.size();
+
+        // key at position i of chain needs i + 1 compares
+        for (const auto& chain: array) {
+            size_t pos = 0;
+            for (auto it = chain.begin(); it != chain.end(); ++it)
+                stats.add_probe(++pos);
+        }
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+
+        return stats.finish();
+    }
 };
 
 } // namespace hashset
\ No newline at end of file
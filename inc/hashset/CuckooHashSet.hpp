@@ -6,6 +6,8 @@
 #include <utility>
 #include <iostream>
 
+#include "IHashSet.hpp"
+
 namespace hashset {
 
 using std::array;
@@ -25,6 +27,9 @@ class CuckooHashSet : public IHashSet<T> {
     Hash1 hash1;
     Hash2 hash2;
 
+    RehashStats rehashes;
+    HotStats hot;
+
     elem_t& get_elem(const T& val, size_t half) {
         half &= 1;
         const size_t hash = half ? hash2(val) : hash1(val);
@@ -52,9 +57,12 @@ class CuckooHashSet : public IHashSet<T> {
     }
 
     void rehash() {
+        auto scope = rehashes.scope();
+
         array<vector<elem_t>, 2> old = std::move(table);
         
         table_size *= 2;
+        populated = 0;
         for (auto& half: table) {
             half.clear();
             half.assign(table_size, nullopt);
@@ -81,6 +89,7 @@ class CuckooHashSet : public IHashSet<T> {
             }
 
             std::swap(drop, elem.value());
+            HASHSET_COUNT(++hot.displacements);
         }
 
         rehash();
@@ -89,6 +98,8 @@ class CuckooHashSet : public IHashSet<T> {
     }
 
 public:
+    using hasher = Hash1;
+
     // dont want size to be zero
     CuckooHashSet(size_t size=16) : 
         table_size(size == 0 ? 16 : size),
@@ -125,6 +136,9 @@ public:
     }
 
     virtual bool find(const T& val) const {
+        HASHSET_COUNT(++hot.lookups);
+        HASHSET_COUNT(hot.probes += 2);
+
         const auto& [elem1, elem2] = get_elems(val);
 
         if (elem1 == val || elem2 == val)
@@ -154,6 +168,35 @@ public:
         return false;
     }
 
+    // part takes the same range of both halves
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(table_size, part, parts);
+        for (const auto& half: table)
+            for (size_t id = from; id < to; ++id)
+                if (half[id]) f(half[id].value());
+    }
+
+    virtual size_t size() const {
+        return populated;
+    }
+
+    // probe length is the half key is stored in
+    virtual HashSetStats stats() const {
+        HashSetStats stats;
+        stats.size = populated;
+        stats.capacity = 2 * table_size;
+
+        for (size_t half = 0; half < table.size(); ++half)
+            for (const auto& elem: table[half])
+                if (elem) stats.add_probe(half + 1);
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+
+        return stats.finish();
+    }
+
     void print(std::ostream& out) {
         out << populated << ": " << std::endl;
         for (const auto& half: table) {
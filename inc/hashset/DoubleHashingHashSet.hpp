@@ -6,6 +6,8 @@ namespace hashset {
 
 template<typename T, class Hash1, class Hash2>
 struct DoubleHashingRun {
+    using hasher = Hash1;
+
     const size_t hash1;
     const size_t hash2;
     const size_t size;
@@ -13,6 +15,10 @@ struct DoubleHashingRun {
     DoubleHashingRun(const T& val, const size_t size) :
         hash1(Hash1{}(val)), hash2(Hash2{}(val)), size(size) {}
 
+    // hash is hasher (first hash) of val computed by caller
+    DoubleHashingRun(const T& val, const size_t hash, const size_t size) :
+        hash1(hash), hash2(Hash2{}(val)), size(size) {}
+
     size_t operator()(size_t i) const {
         // here second hash is always odd
         // so it is mutually simple with size
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+
+#include "IHashSet.hpp"
+#include "../filter/BlockedBloomFilter.hpp"
+#include "../filter/CuckooFilter.hpp"
+
+namespace hashset {
+
+// whether set has find(val, h) taking hash computed by caller
+template<class Set, typename T, class=void>
+struct takes_hash : std::false_type {};
+
+template<class Set, typename T>
+struct takes_hash<Set, T, std::void_t<decltype(
+    std::declval<const Set&>().find(std::declval<const T&>(), size_t(0)))>> :
+    std::true_type {};
+
+// answers negative find and remove from a compact filter
+// before touching inner set, filter is keyed by inner
+// set hasher and rebuilt from inner set when it is full
+template<typename T, class Inner, class Filter=BlockedBloomFilter>
+class FilteredHashSet : public IHashSet<T> {
+    using Hash = typename Inner::hasher;
+
+    static constexpr size_t min_capacity = 1024;
+
+    Inner inner;
+    Filter filter;
+    Hash hash;
+    size_t live;
+
+    RehashStats rebuilds;
+
+    static constexpr bool hashed = takes_hash<Inner, T>::value;
+
+    inline void rebuild() {
+        if (!filter.full()) return;
+        auto scope = rebuilds.scope();
+
+        Filter fresh(std::max(live * 2, min_capacity));
+        inner.for_each([&](const T& val) {
+            fresh.insert(hash(val));
+        });
+
+        filter = std::move(fresh);
+    }
+
+public:
+    // not picked instead of copy and move constructors
+    template<typename... Args, typename=std::enable_if_t<
+        !(sizeof...(Args) == 1 &&
+          (std::is_same_v<std::decay_t<Args>, FilteredHashSet> && ...))>>
+    FilteredHashSet(Args&&... args) :
+        inner(std::forward<Args>(args)...),
+        filter(min_capacity), live(0) {}
+
+    // key is hashed once, inner set gets
+    // the hash when it could take it
+    virtual bool insert(const T& val) override {
+        const size_t h = hash(val);
+        if constexpr (hashed) {
+            if (!inner.insert(val, h))
+                return false;
+        } else if (!inner.insert(val)) {
+            return false;
+        }
+
+        filter.insert(h);
+        ++live;
+        rebuild();
+
+        return true;
+    }
+
+    virtual bool find(const T& val) const override {
+        const size_t h = hash(val);
+        if (!filter.contains(h))
+            return false;
+
+        if constexpr (hashed) return inner.find(val, h);
+        else return inner.find(val);
+    }
+
+    virtual bool remove(const T& val) override {
+        const size_t h = hash(val);
+        if (!filter.contains(h))
+            return false;
+
+        if constexpr (hashed) {
+            if (!inner.remove(val, h))
+                return false;
+        } else if (!inner.remove(val)) {
+            return false;
+        }
+
+        filter.remove(h);
+        --live;
+        rebuild();
+
+        return true;
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    // rehashes are the ones of inner set plus filter rebuilds
+    virtual HashSetStats stats() const override {
+        HashSetStats stats = inner.stats();
+        stats.rehashes += rebuilds.count;
+        stats.rehash_time += rebuilds.time;
+
+        return stats;
+    }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        inner.for_each(f, part, parts);
+    }
+
+    size_t filter_bytes() const {
+        return filter.bytes();
+    }
+};
+
+} // namespace hashset
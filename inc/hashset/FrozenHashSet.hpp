@@ -0,0 +1,429 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+
+#include "IHashSet.hpp"
+
+namespace hashset {
+
+using std::string;
+using std::vector;
+
+// false if stream is seekable and has less than bytes
+// left, so corrupted sizes fail before allocating
+inline bool has_bytes(std::istream& in, uint64_t bytes) {
+    const auto pos = in.tellg();
+    if (pos < 0) return true;
+
+    in.seekg(0, std::ios::end);
+    const auto end = in.tellg();
+    in.seekg(pos);
+
+    return end < 0 || uint64_t(end - pos) >= bytes;
+}
+
+// keys of frozen set in the order of their slots
+template<typename T>
+class PackedKeys {
+    static_assert(std::is_trivially_copyable_v<T>,
+        "Only trivially copyable keys and strings could be packed");
+
+    vector<T> keys;
+
+public:
+    void build(const vector<const T*>& slots) {
+        keys.clear();
+        keys.reserve(slots.size());
+        for (const T* key: slots)
+            keys.push_back(*key);
+    }
+
+    bool equal(size_t slot, const T& val) const {
+        return keys[slot] == val;
+    }
+
+    const T& get(size_t slot) const {
+        return keys[slot];
+    }
+
+    size_t bytes() const {
+        return keys.size() * sizeof(T);
+    }
+
+    void save(std::ostream& out) const {
+        out.write((const char*)keys.data(), keys.size() * sizeof(T));
+    }
+
+    void load(std::istream& in, size_t n) {
+        if (!has_bytes(in, n * sizeof(T)))
+            throw std::runtime_error("Corrupted frozen set");
+
+        keys.resize(n);
+        in.read((char*)keys.data(), n * sizeof(T));
+    }
+};
+
+// strings are stored back to back in one arena
+template<>
+class PackedKeys<string> {
+    string arena;
+    // key in slot i is arena[offsets[i], offsets[i + 1])
+    vector<uint32_t> offsets;
+
+public:
+    void build(const vector<const string*>& slots) {
+        size_t total = 0;
+        for (const string* key: slots)
+            total += key->size();
+        if (total > UINT32_MAX)
+            throw std::length_error("Too many bytes to pack");
+
+        arena.clear();
+        arena.reserve(total);
+        offsets.assign(1, 0);
+        offsets.reserve(slots.size() + 1);
+
+        for (const string* key: slots) {
+            arena += *key;
+            offsets.push_back(arena.size());
+        }
+    }
+
+    bool equal(size_t slot, const string& val) const {
+        const size_t from = offsets[slot];
+        const size_t len = offsets[slot + 1] - from;
+        return len == val.size() &&
+            std::memcmp(arena.data() + from, val.data(), len) == 0;
+    }
+
+    string get(size_t slot) const {
+        return arena.substr(offsets[slot], offsets[slot + 1] - offsets[slot]);
+    }
+
+    size_t bytes() const {
+        return arena.size() + offsets.size() * sizeof(uint32_t);
+    }
+
+    void save(std::ostream& out) const {
+        const uint64_t size = arena.size();
+        out.write((const char*)&size, sizeof(size));
+        out.write((const char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+        out.write(arena.data(), arena.size());
+    }
+
+    void load(std::istream& in, size_t n) {
+        uint64_t size = 0;
+        in.read((char*)&size, sizeof(size));
+        if (!in || !has_bytes(in, (n + 1) * sizeof(uint32_t) + size))
+            throw std::runtime_error("Corrupted frozen set");
+
+        offsets.resize(n + 1);
+        in.read((char*)offsets.data(), offsets.size() * sizeof(uint32_t));
+        if (!in || offsets.front() != 0 || offsets.back() != size ||
+            !std::is_sorted(offsets.begin(), offsets.end()))
+            throw std::runtime_error("Corrupted frozen set");
+
+        arena.resize(size);
+        in.read(arena.data(), size);
+    }
+};
+
+// read-only set over minimal perfect hash (pthash-like):
+// keys are split to buckets, every bucket gets a pilot
+// that sends all its keys to free slots, so lookup is
+// one pilot read, one slot and one key compare
+template<typename T, class Hash=std::hash<T>>
+class FrozenHashSet : public IHashSet<T> {
+    // mean keys per bucket
+    static constexpr size_t bucket_load = 4;
+    // slots are 1% more than keys, the ones
+    // past the end are remapped to free slots
+    static constexpr double alpha = 0.99;
+    static constexpr size_t max_pilot = UINT16_MAX;
+    static constexpr size_t max_seeds = 64;
+    static constexpr uint64_t magic = 0x4e455a4f5246484cULL;
+
+    Hash hash;
+
+    uint64_t seed = 0;
+    size_t live = 0;
+    size_t slots = 0;
+    vector<uint16_t> pilots;
+    vector<uint32_t> remap;
+    PackedKeys<T> keys;
+
+    static inline uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static inline size_t reduce(uint64_t h, size_t n) {
+        return (unsigned __int128)(h) * n >> 64;
+    }
+
+    static size_t slots_for(size_t size) {
+        return size ? std::max<size_t>(size / alpha, size + 1) : 0;
+    }
+
+    inline uint64_t key_hash(const T& val) const {
+        return mix(hash(val) ^ seed);
+    }
+
+    inline size_t bucket(uint64_t h) const {
+        return reduce(h, pilots.size());
+    }
+
+    inline size_t position(uint64_t h, size_t pilot) const {
+        return reduce(mix(h ^ (pilot * 0x9e3779b97f4a7c15ULL)), slots);
+    }
+
+    inline size_t slot(uint64_t h) const {
+        const size_t pos = position(h, pilots[bucket(h)]);
+        return pos < live ? pos : remap[pos - live];
+    }
+
+    // false means some bucket found no pilot with this seed
+    bool place(const vector<const T*>& unique, vector<const T*>& by_slot) {
+        const size_t n = unique.size();
+
+        vector<uint64_t> hashes(n);
+        for (size_t i = 0; i < n; ++i)
+            hashes[i] = key_hash(*unique[i]);
+
+        // counting sort of keys by bucket
+        vector<size_t> start(pilots.size() + 1, 0);
+        for (uint64_t h: hashes) ++start[bucket(h) + 1];
+        for (size_t b = 0; b < pilots.size(); ++b) start[b + 1] += start[b];
+
+        vector<uint32_t> members(n);
+        {
+            vector<size_t> fill(start.begin(), start.end() - 1);
+            for (size_t i = 0; i < n; ++i)
+                members[fill[bucket(hashes[i])]++] = i;
+        }
+
+        // biggest buckets are placed first, while table is empty
+        vector<uint32_t> order(pilots.size());
+        for (size_t b = 0; b < order.size(); ++b) order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return start[a + 1] - start[a] > start[b + 1] - start[b];
+        });
+
+        vector<bool> taken(slots, false);
+        vector<size_t> pos;
+
+        for (const uint32_t b: order) {
+            const size_t from = start[b], to = start[b + 1];
+            if (from == to) break;
+
+            bool placed = false;
+            for (size_t pilot = 0; pilot <= max_pilot && !placed; ++pilot) {
+                pos.clear();
+                placed = true;
+                for (size_t i = from; i < to && placed; ++i) {
+                    const size_t p = position(hashes[members[i]], pilot);
+                    placed = !taken[p] &&
+                        std::find(pos.begin(), pos.end(), p) == pos.end();
+                    pos.push_back(p);
+                }
+
+                if (placed) {
+                    pilots[b] = pilot;
+                    for (size_t p: pos) taken[p] = true;
+                }
+            }
+
+            if (!placed) return false;
+        }
+
+        by_slot.assign(slots, nullptr);
+        for (size_t i = 0; i < n; ++i)
+            by_slot[position(hashes[i], pilots[bucket(hashes[i])])] = unique[i];
+
+        // move keys from slots past the end to free slots
+        remap.assign(slots - n, 0);
+        size_t free = 0;
+        for (size_t past = n; past < slots; ++past) {
+            if (!by_slot[past]) continue;
+
+            while (by_slot[free]) ++free;
+            by_slot[free] = by_slot[past];
+            by_slot[past] = nullptr;
+            remap[past - n] = free;
+        }
+
+        by_slot.resize(n);
+        return true;
+    }
+
+    void build(const vector<const T*>& all) {
+        vector<std::pair<size_t, const T*>> hashed;
+        hashed.reserve(all.size());
+        for (const T* key: all)
+            hashed.emplace_back(hash(*key), key);
+
+        // the same key could come twice, but different
+        // keys with the same hash could not be told apart
+        std::sort(hashed.begin(), hashed.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        vector<const T*> unique;
+        unique.reserve(hashed.size());
+        for (size_t i = 0; i < hashed.size(); ++i) {
+            if (i && hashed[i - 1].first == hashed[i].first) {
+                if (*unique.back() == *hashed[i].second) continue;
+                throw std::runtime_error("Hash collision, keys could not be frozen");
+            }
+            unique.push_back(hashed[i].second);
+        }
+
+        live = unique.size();
+        slots = slots_for(live);
+        pilots.assign(live / bucket_load + 1, 0);
+
+        vector<const T*> by_slot;
+        for (seed = 0; seed < max_seeds; ++seed) {
+            std::fill(pilots.begin(), pilots.end(), 0);
+            if (place(unique, by_slot)) {
+                keys.build(by_slot);
+                return;
+            }
+        }
+
+        throw std::runtime_error("Failed to build perfect hash");
+    }
+
+    FrozenHashSet() = default;
+
+public:
+    using hasher = Hash;
+
+    template<class It>
+    FrozenHashSet(It first, It last) {
+        vector<const T*> all;
+        for (; first != last; ++first)
+            all.push_back(&*first);
+        build(all);
+    }
+
+    // snapshot of any set with for_each, keys are copied
+    // since for_each could pass them as temporaries
+    template<class Set>
+    static FrozenHashSet from(const Set& set) {
+        vector<T> owned;
+        set.for_each([&](const T& val) {
+            owned.push_back(val);
+        });
+
+        return FrozenHashSet(owned.begin(), owned.end());
+    }
+
+    virtual bool insert(const T&) override {
+        throw std::logic_error("FrozenHashSet is read-only");
+    }
+
+    virtual bool find(const T& val) const override {
+        if (!live) return false;
+
+        return keys.equal(slot(key_hash(val)), val);
+    }
+
+    virtual bool remove(const T&) override {
+        throw std::logic_error("FrozenHashSet is read-only");
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    // every key is found with exactly one probe
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = live;
+        if (live) stats.histogram.assign(1, live);
+        stats.max_probe = live ? 1 : 0;
+
+        return stats.finish();
+    }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(live, part, parts);
+        for (size_t i = from; i < to; ++i)
+            f(keys.get(i));
+    }
+
+    size_t bytes() const {
+        return keys.bytes() +
+            pilots.size() * sizeof(uint16_t) +
+            remap.size() * sizeof(uint32_t);
+    }
+
+    // hash is not saved, set should be
+    // loaded with the same Hash it was saved with
+    void save(std::ostream& out) const {
+        const uint64_t header[] = {
+            magic, seed, live, slots, pilots.size(), remap.size()
+        };
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)pilots.data(), pilots.size() * sizeof(uint16_t));
+        out.write((const char*)remap.data(), remap.size() * sizeof(uint32_t));
+        keys.save(out);
+    }
+
+    static FrozenHashSet load(std::istream& in) {
+        uint64_t header[6];
+        in.read((char*)header, sizeof(header));
+        if (!in || header[0] != magic)
+            throw std::runtime_error("Not a frozen set");
+
+        FrozenHashSet frozen;
+        frozen.seed = header[1];
+        frozen.live = header[2];
+        frozen.slots = header[3];
+        // slots are derived from size the same way build does
+        if (frozen.live > UINT32_MAX ||
+            frozen.slots != slots_for(frozen.live) ||
+            header[4] != frozen.live / bucket_load + 1 ||
+            header[5] != frozen.slots - frozen.live)
+            throw std::runtime_error("Corrupted frozen set");
+
+        if (!has_bytes(in, header[4] * sizeof(uint16_t) + header[5] * sizeof(uint32_t)))
+            throw std::runtime_error("Corrupted frozen set");
+
+        frozen.pilots.resize(header[4]);
+        frozen.remap.resize(header[5]);
+        in.read((char*)frozen.pilots.data(), frozen.pilots.size() * sizeof(uint16_t));
+        in.read((char*)frozen.remap.data(), frozen.remap.size() * sizeof(uint32_t));
+        frozen.keys.load(in, frozen.live);
+
+        if (!in)
+            throw std::runtime_error("Corrupted frozen set");
+
+        // pilots always give positions below slots,
+        // ones past the end should be remapped into keys
+        for (const uint32_t slot: frozen.remap)
+            if (slot >= frozen.live)
+                throw std::runtime_error("Corrupted frozen set");
+
+        return frozen;
+    }
+};
+
+} // namespace hashset
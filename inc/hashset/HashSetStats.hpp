@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+#include <vector>
+#include <ostream>
+#include <atomic>
+
+// hot path counters cost a branchless increment
+// on every operation, so they are off by default
+#ifdef HASHSET_STATS
+#define HASHSET_COUNT(expr) (expr)
+#else
+#define HASHSET_COUNT(expr) ((void)0)
+#endif
+
+namespace hashset {
+
+using std::vector;
+
+struct HashSetStats {
+    // stored keys
+    size_t size = 0;
+    // slots of open addressing or buckets of chaining
+    size_t capacity = 0;
+    double load_factor = 0;
+    size_t tombstones = 0;
+
+    // probes (or chain position) needed to find each
+    // stored key, histogram[i] is number of keys found
+    // with i + 1 probes
+    vector<size_t> histogram;
+    size_t max_probe = 0;
+    double mean_probe = 0;
+
+    size_t rehashes = 0;
+    std::chrono::nanoseconds rehash_time{0};
+
+    // only counted with HASHSET_STATS
+    size_t lookups = 0;
+    size_t probes = 0;
+    size_t displacements = 0;
+
+    void add_probe(size_t length) {
+        if (histogram.size() < length)
+            histogram.resize(length, 0);
+        ++histogram[length - 1];
+
+        if (length > max_probe)
+            max_probe = length;
+    }
+
+    // fills values derived from collected ones
+    HashSetStats& finish() {
+        load_factor = capacity ? double(size + tombstones) / capacity : 0;
+
+        size_t keys = 0, total = 0;
+        for (size_t i = 0; i < histogram.size(); ++i) {
+            keys += histogram[i];
+            total += histogram[i] * (i + 1);
+        }
+        mean_probe = keys ? double(total) / keys : 0;
+
+        return *this;
+    }
+};
+
+// number and time of rehashes, rehash could
+// trigger another one from inside, so only
+// outermost one is timed
+struct RehashStats {
+    size_t count = 0;
+    std::chrono::nanoseconds time{0};
+    size_t depth = 0;
+
+    class Scope {
+        RehashStats& stats;
+        const std::chrono::steady_clock::time_point start;
+
+    public:
+        Scope(RehashStats& stats) :
+            stats(stats), start(std::chrono::steady_clock::now()) {
+            ++stats.count;
+            ++stats.depth;
+        }
+
+        Scope(const Scope&) = delete;
+
+        ~Scope() {
+            if (--stats.depth == 0)
+                stats.time += std::chrono::steady_clock::now() - start;
+        }
+    };
+
+    Scope scope() {
+        return Scope(*this);
+    }
+
+    void fill(HashSetStats& stats) const {
+        stats.rehashes = count;
+        stats.rehash_time = time;
+    }
+};
+
+// counter bumped by finds that may run concurrently,
+// adds are relaxed atomics, copies take a snapshot
+class Counter {
+    std::atomic<size_t> value{0};
+
+public:
+    Counter() = default;
+
+    Counter(const Counter& other) :
+        value(other.value.load(std::memory_order_relaxed)) {}
+
+    Counter& operator=(const Counter& other) {
+        value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    Counter& operator++() {
+        value.fetch_add(1, std::memory_order_relaxed);
+        return *this;
+    }
+
+    Counter& operator+=(size_t n) {
+        value.fetch_add(n, std::memory_order_relaxed);
+        return *this;
+    }
+
+    operator size_t() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// counters of the hot path, empty unless HASHSET_STATS
+struct HotStats {
+#ifdef HASHSET_STATS
+    mutable Counter lookups;
+    mutable Counter probes;
+    mutable Counter displacements;
+#endif
+
+    void fill(HashSetStats& stats) const {
+#ifdef HASHSET_STATS
+        stats.lookups = lookups;
+        stats.probes = probes;
+        stats.displacements = displacements;
+#endif
+        (void)stats;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const HashSetStats& stats) {
+    out << "size " << stats.size
+        << " capacity " << stats.capacity
+        << " load " << stats.load_factor
+        << " tombstones " << stats.tombstones
+        << " probe " << stats.mean_probe << "/" << stats.max_probe
+        << " rehashes " << stats.rehashes
+        << " (" << stats.rehash_time.count() << "ns)";
+#ifdef HASHSET_STATS
+    out << " lookups " << stats.lookups
+        << " probes " << stats.probes
+        << " displacements " << stats.displacements;
+#endif
+    return out;
+}
+
+} // namespace hashset
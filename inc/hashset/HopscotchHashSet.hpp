@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <type_traits>
+
+#include "IHashSet.hpp"
+
+namespace hashset {
+
+using std::vector;
+using std::optional;
+using std::nullopt;
+
+// every key lives within H slots from its home bucket,
+// home bucket bitmap tells which of them hold its keys,
+// so lookup never leaves the neighborhood
+template<typename T, class Hash=std::hash<T>, size_t H=32>
+class HopscotchHashSet : public IHashSet<T> {
+    static_assert(H == 32 || H == 64, "Neighborhood should be 32 or 64");
+
+    using bitmap_t = std::conditional_t<H == 64, uint64_t, uint32_t>;
+
+    struct Bucket {
+        bitmap_t hop = 0;
+        optional<T> val;
+    };
+
+    // how far free slot is looked for before giving up,
+    // runs at 0.9 load are often longer than 8 * H
+    static constexpr size_t max_distance = 32 * H;
+
+    Hash hash;
+    vector<Bucket> array;
+    size_t mask;
+
+    const double factor;
+    size_t live;
+
+    RehashStats rehashes;
+    HotStats hot;
+
+    static inline size_t lowest(bitmap_t bits) {
+        return __builtin_ctzll(bits);
+    }
+
+    inline size_t home(const T& val) const {
+        return hash(val) & mask;
+    }
+
+    // slot of val or array.size() if there is none
+    inline size_t locate(const T& val, size_t from) const {
+        for (bitmap_t bits = array[from].hop; bits; bits &= bits - 1) {
+            HASHSET_COUNT(++hot.probes);
+
+            const size_t id = (from + lowest(bits)) & mask;
+            if (array[id].val == val)
+                return id;
+        }
+
+        return array.size();
+    }
+
+    // moves some key closer to its home, so that free
+    // slot gets closer to the bucket we are inserting to,
+    // returns new free slot or array.size() if nothing moves
+    size_t hop(size_t free) {
+        for (size_t dist = H - 1; dist > 0; --dist) {
+            const size_t from = (free - dist) & mask;
+
+            // only keys before free slot could go there
+            bitmap_t bits = array[from].hop & ((bitmap_t(1) << dist) - 1);
+            if (!bits) continue;
+
+            const size_t off = lowest(bits);
+            const size_t id = (from + off) & mask;
+
+            array[free].val = std::move(array[id].val);
+            array[id].val = nullopt;
+            array[from].hop &= ~(bitmap_t(1) << off);
+            array[from].hop |= bitmap_t(1) << dist;
+            HASHSET_COUNT(++hot.displacements);
+
+            return id;
+        }
+
+        return array.size();
+    }
+
+    // false means no hop could free a slot in neighborhood
+    bool place(T&& val) {
+        const size_t from = home(val);
+
+        size_t dist = 0;
+        while (dist < max_distance && dist < array.size() &&
+               array[(from + dist) & mask].val)
+            ++dist;
+
+        if (dist == max_distance || dist == array.size())
+            return false;
+
+        size_t free = (from + dist) & mask;
+        while (dist >= H) {
+            free = hop(free);
+            if (free == array.size())
+                return false;
+
+            dist = (free - from) & mask;
+        }
+
+        array[free].val = std::move(val);
+        array[from].hop |= bitmap_t(1) << dist;
+
+        return true;
+    }
+
+    void rehash(size_t capacity) {
+        auto scope = rehashes.scope();
+
+        vector<Bucket> elems = std::move(array);
+
+        for (;; capacity *= 2) {
+            array.clear();
+            array.resize(capacity);
+            mask = capacity - 1;
+
+            bool done = true;
+            for (auto& elem: elems) {
+                if (!elem.val) continue;
+
+                // key is moved only if it was placed
+                if (!place(std::move(elem.val.value()))) {
+                    done = false;
+                    break;
+                }
+                elem.val = nullopt;
+            }
+
+            if (done) return;
+
+            // take placed keys back and try a bigger table
+            for (auto& elem: array)
+                if (elem.val)
+                    elems.push_back({0, std::move(elem.val)});
+        }
+    }
+
+public:
+    using hasher = Hash;
+
+    // size of array should be always power of 2
+    HopscotchHashSet(double factor=0.9) :
+        array(16), mask(15), factor(factor), live(0) {}
+
+    virtual bool insert(const T& val) override {
+        if (find(val))
+            return false;
+
+        if (live + 1 > array.size() * factor)
+            rehash(array.size() * 2);
+
+        while (!place(T(val)))
+            rehash(array.size() * 2);
+
+        ++live;
+
+        return true;
+    }
+
+    virtual bool find(const T& val) const override {
+        HASHSET_COUNT(++hot.lookups);
+
+        return locate(val, home(val)) != array.size();
+    }
+
+    virtual bool remove(const T& val) override {
+        const size_t from = home(val);
+        const size_t id = locate(val, from);
+
+        if (id == array.size())
+            return false;
+
+        array[id].val = nullopt;
+        array[from].hop &= ~(bitmap_t(1) << ((id - from) & mask));
+        --live;
+
+        return true;
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    // probe length is distance from home bucket
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = array.size();
+
+        for (size_t from = 0; from < array.size(); ++from)
+            for (bitmap_t bits = array[from].hop; bits; bits &= bits - 1)
+                stats.add_probe(lowest(bits) + 1);
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+
+        return stats.finish();
+    }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(array.size(), part, parts);
+        for (size_t id = from; id < to; ++id)
+            if (array[id].val) f(array[id].val.value());
+    }
+};
+
+} // namespace hashset
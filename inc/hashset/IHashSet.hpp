@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <utility>
+
+#include "HashSetStats.hpp"
+
 namespace hashset {
 
 template<typename T>
@@ -8,6 +13,16 @@ public:
     virtual bool insert(const T& val) = 0;
     virtual bool find(const T& val) const = 0;
     virtual bool remove(const T& val) = 0;
+    // number of keys, never walks the table
+    virtual size_t size() const = 0;
+    virtual HashSetStats stats() const = 0;
 };
 
+// slots [first, second) of part out of parts, every
+// for_each(f, part, parts) walks one such range of its
+// storage in memory order, so parts could go to threads
+inline std::pair<size_t, size_t> part_bounds(size_t n, size_t part, size_t parts) {
+    return {n * part / parts, n * (part + 1) / parts};
+}
+
 } // namespace
\ No newline at end of file
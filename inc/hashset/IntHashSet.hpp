@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "IHashSet.hpp"
+#include "../hash/fmix64.hpp"
+
+namespace hashset {
+
+using std::vector;
+
+// open addressing over raw 64 bit keys: table is an array
+// of cache line groups of 8 keys, probing goes group by
+// group and compares whole group at once, two key values
+// are reserved as empty and tombstone marks, those keys
+// themselves are kept aside
+template<class Hash=fmix64hash<size_t>>
+class IntHashSet : public IHashSet<uint64_t> {
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr uint64_t TOMBSTONE = 1;
+    static constexpr size_t lanes = 8;
+    // some slot has to stay empty, or probing never ends
+    static constexpr double max_factor = 0.95;
+
+    struct alignas(64) Group {
+        uint64_t keys[lanes];
+    };
+
+    Hash hash;
+    vector<Group> groups;
+    size_t mask;
+
+    const double factor;
+    // keys in table and kept aside
+    size_t live;
+    // slots that are not empty, tombstones included
+    size_t populated;
+    size_t tombstones;
+    // whether EMPTY and TOMBSTONE keys are in set
+    bool special[2];
+    // lengths[i] is number of keys stored i groups
+    // past home, kept so stats never rehash keys
+    vector<size_t> lengths;
+
+    RehashStats rehashes;
+    HotStats hot;
+
+    // bit i is set if lane i equals key
+    static inline unsigned match(const Group& group, uint64_t key) {
+#if defined(__AVX512F__)
+        const __m512i keys = _mm512_load_si512(group.keys);
+        return _mm512_cmpeq_epi64_mask(keys, _mm512_set1_epi64(key));
+#elif defined(__AVX2__)
+        const __m256i k = _mm256_set1_epi64x(key);
+        const __m256i lo = _mm256_load_si256((const __m256i*)group.keys);
+        const __m256i hi = _mm256_load_si256((const __m256i*)(group.keys + 4));
+        const unsigned mlo = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(lo, k)));
+        const unsigned mhi = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(hi, k)));
+        return mlo | mhi << 4;
+#else
+        unsigned res = 0;
+        for (size_t i = 0; i < lanes; ++i)
+            res |= unsigned(group.keys[i] == key) << i;
+        return res;
+#endif
+    }
+
+    static inline bool is_special(uint64_t val) {
+        return val == EMPTY || val == TOMBSTONE;
+    }
+
+    inline size_t home(uint64_t val) const {
+        return hash(val) & mask;
+    }
+
+    // group and lane of val or groups.size() if there is none,
+    // from is home of val
+    inline size_t locate(uint64_t val, size_t from) const {
+        size_t g = from;
+        for (size_t i = 0; i < groups.size(); ++i, g = (g + 1) & mask) {
+            HASHSET_COUNT(++hot.probes);
+
+            const Group& group = groups[g];
+            if (const unsigned found = match(group, val))
+                return g * lanes + __builtin_ctz(found);
+            if (match(group, EMPTY))
+                break;
+        }
+
+        return groups.size() * lanes;
+    }
+
+    void place(uint64_t val) {
+        const size_t from = home(val);
+        for (size_t g = from;; g = (g + 1) & mask) {
+            Group& group = groups[g];
+            const unsigned free = match(group, EMPTY) | match(group, TOMBSTONE);
+            if (!free) continue;
+
+            uint64_t& slot = group.keys[__builtin_ctz(free)];
+            if (slot == EMPTY) ++populated;
+            else --tombstones;
+            slot = val;
+
+            const size_t dist = (g - from) & mask;
+            if (lengths.size() <= dist)
+                lengths.resize(dist + 1, 0);
+            ++lengths[dist];
+
+            return;
+        }
+    }
+
+    inline void rehash() {
+        if (populated + 1 <= groups.size() * lanes * factor) return;
+        auto scope = rehashes.scope();
+
+        // there could be just too many tombstones
+        size_t count = groups.size();
+        if (live * 2 >= groups.size() * lanes * factor)
+            count *= 2;
+
+        vector<Group> old = std::move(groups);
+        groups.assign(count, Group{});
+        mask = count - 1;
+        populated = tombstones = 0;
+        lengths.clear();
+
+        for (const Group& group: old)
+            for (const uint64_t key: group.keys)
+                if (!is_special(key))
+                    place(key);
+    }
+
+public:
+    using hasher = Hash;
+
+    // size of table should be always power of 2
+    IntHashSet(double factor=0.8) :
+        groups(2, Group{}), mask(1), factor(std::min(factor, max_factor)),
+        live(0), populated(0), tombstones(0), special{false, false} {}
+
+    virtual bool insert(const uint64_t& val) override {
+        if (is_special(val)) {
+            if (special[val]) return false;
+            special[val] = true;
+            ++live;
+            return true;
+        }
+
+        if (find(val))
+            return false;
+
+        rehash();
+        place(val);
+        ++live;
+
+        return true;
+    }
+
+    virtual bool find(const uint64_t& val) const override {
+        HASHSET_COUNT(++hot.lookups);
+
+        if (is_special(val))
+            return special[val];
+
+        return locate(val, home(val)) != groups.size() * lanes;
+    }
+
+    virtual bool remove(const uint64_t& val) override {
+        if (is_special(val)) {
+            if (!special[val]) return false;
+            special[val] = false;
+            --live;
+            return true;
+        }
+
+        const size_t from = home(val);
+        const size_t id = locate(val, from);
+        if (id == groups.size() * lanes)
+            return false;
+
+        groups[id / lanes].keys[id % lanes] = TOMBSTONE;
+        --lengths[(id / lanes - from) & mask];
+        ++tombstones;
+        --live;
+
+        return true;
+    }
+
+    virtual size_t size() const override {
+        return live;
+    }
+
+    // probe length is number of groups looked at
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = groups.size() * lanes;
+        stats.tombstones = tombstones;
+
+        stats.histogram = lengths;
+        while (!stats.histogram.empty() && !stats.histogram.back())
+            stats.histogram.pop_back();
+        stats.max_probe = stats.histogram.size();
+
+        for (bool kept: special)
+            if (kept) stats.add_probe(1);
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+        stats.finish();
+
+        // keys kept aside do not occupy slots
+        stats.load_factor = double(populated) / stats.capacity;
+
+        return stats;
+    }
+
+    // keys kept aside go with the first part
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        if (part == 0)
+            for (uint64_t key = EMPTY; key <= TOMBSTONE; ++key)
+                if (special[key]) f(key);
+
+        const auto [from, to] = part_bounds(groups.size(), part, parts);
+        for (size_t g = from; g < to; ++g)
+            for (const uint64_t key: groups[g].keys)
+                if (!is_special(key)) f(key);
+    }
+};
+
+} // namespace hashset
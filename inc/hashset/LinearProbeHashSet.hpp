@@ -6,12 +6,18 @@ namespace hashset {
 
 template<typename T, class Hash>
 struct SimpleRun {
+    using hasher = Hash;
+
     const size_t hash;
     const size_t size;
 
     SimpleRun(const T& val, const size_t size) :
         hash(Hash{}(val)), size(size) {}
 
+    // hash is hasher of val computed by caller
+    SimpleRun(const T&, const size_t hash, const size_t size) :
+        hash(hash), size(size) {}
+
     size_t operator()(size_t i) const {
         return (hash + i) % size;
     }
@@ -17,9 +17,9 @@ using std::vector;
 using std::variant;
 using std::function;
 
-// here size and scale are templates cause
+// here initial size and scale are templates cause
 // implementations need to strictly control it
-template<typename T, class Run, size_t size, size_t scale>
+template<typename T, class Run, size_t initial, size_t scale>
 class OpenKeyHashSet : public IHashSet<T> {
     enum EmptyState {
         EMPTY,
@@ -33,6 +33,15 @@ class OpenKeyHashSet : public IHashSet<T> {
     const double factor;
     size_t populated;
 
+    // kept on insert and remove, so stats never rehash keys
+    size_t live;
+    size_t tombstones;
+    // lengths[i] is number of keys stored at run step i
+    vector<size_t> lengths;
+
+    RehashStats rehashes;
+    HotStats hot;
+
     static inline bool is_tombs(const elem_t& elem) {
         return  std::holds_alternative<EmptyState>(elem) &&
                 std::get<EmptyState>(elem) == TOMBSTONE;
@@ -53,11 +62,14 @@ class OpenKeyHashSet : public IHashSet<T> {
 
     inline void rehash() {
         if (populated < array.size() * factor) return;
+        auto scope = rehashes.scope();
 
         vector<elem_t> elems = std::move(array);
         
         array.clear();
         populated = 0;
+        live = tombstones = 0;
+        lengths.clear();
         array.assign(elems.size() * scale, EMPTY);
         
         for (elem_t& elem: elems) {
@@ -71,16 +83,23 @@ class OpenKeyHashSet : public IHashSet<T> {
     }
 
 public:
+    using hasher = typename Run::hasher;
+
     OpenKeyHashSet(double factor=0.75) : 
-        factor(factor), populated(0), array(size, EMPTY) {}
+        factor(factor), populated(0), live(0), tombstones(0), array(initial, EMPTY) {}
 
     virtual bool insert(const T& val) override {
+        return insert(val, hasher{}(val));
+    }
+
+    // h is hasher of val, so wrappers hash key once
+    bool insert(const T& val, size_t h) {
         rehash();
 
-        if (find(val))
+        if (find(val, h))
             return false;
 
-        Run run(val, array.size());
+        Run run(val, h, array.size());
         for (size_t i = 0; i < array.size(); ++i) {
             const size_t& id = run(i);
             auto& elem = array.at(id);
@@ -88,8 +107,15 @@ public:
             if (is_tombs(elem) || is_empty(elem)) {
                 if (is_empty(elem)) 
                     ++populated;
+                else
+                    --tombstones;
                 elem = val;
 
+                ++live;
+                if (lengths.size() <= i)
+                    lengths.resize(i + 1, 0);
+                ++lengths[i];
+
                 return true;
             }
         }
@@ -99,8 +125,16 @@ public:
     }
 
     virtual bool find(const T& val) const override {
-        Run run(val, array.size());
+        return find(val, hasher{}(val));
+    }
+
+    bool find(const T& val, size_t h) const {
+        HASHSET_COUNT(++hot.lookups);
+
+        Run run(val, h, array.size());
         for (size_t i = 0; i < array.size(); ++i) {
+            HASHSET_COUNT(++hot.probes);
+
             const size_t& id = run(i);
             const auto& elem = array.at(id);
 
@@ -118,7 +152,11 @@ public:
     }
 
     virtual bool remove(const T& val) override {
-        Run run(val, array.size());
+        return remove(val, hasher{}(val));
+    }
+
+    bool remove(const T& val, size_t h) {
+        Run run(val, h, array.size());
         for (size_t i = 0; i < array.size(); ++i) {
             const size_t& id = run(i);
             auto& elem = array.at(id);
@@ -132,6 +170,10 @@ public:
             if (get_val(elem) == val) {
                 elem = TOMBSTONE;
 
+                --live;
+                ++tombstones;
+                --lengths[i];
+
                 return true; 
             }
         }
@@ -139,6 +181,35 @@ public:
         return false;
     }
 
+    virtual size_t size() const override {
+        return live;
+    }
+
+    virtual HashSetStats stats() const override {
+        HashSetStats stats;
+        stats.size = live;
+        stats.capacity = array.size();
+        stats.tombstones = tombstones;
+
+        stats.histogram = lengths;
+        while (!stats.histogram.empty() && !stats.histogram.back())
+            stats.histogram.pop_back();
+        stats.max_probe = stats.histogram.size();
+
+        rehashes.fill(stats);
+        hot.fill(stats);
+
+        return stats.finish();
+    }
+
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        const auto [from, to] = part_bounds(array.size(), part, parts);
+        for (size_t id = from; id < to; ++id)
+            if (!is_empty(array[id]) && !is_tombs(array[id]))
+                f(get_val(array[id]));
+    }
+
     void print(std::ostream& out) {
         out << populated << ": ";
         for (const auto& elem: array) {
@@ -6,12 +6,18 @@ namespace hashset {
 
 template<typename T, class Hash>
 struct QuadraticRun {
+    using hasher = Hash;
+
     const size_t hash;
     const size_t size;
 
     QuadraticRun(const T& val, const size_t size) :
         hash(Hash{}(val)), size(size) {}
 
+    // hash is hasher of val computed by caller
+    QuadraticRun(const T&, const size_t hash, const size_t size) :
+        hash(hash), size(size) {}
+
     size_t operator()(size_t i) const {
         size_t id = hash + (i + i*i) >> 1;
         return id % size;
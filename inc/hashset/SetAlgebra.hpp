@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include "IHashSet.hpp"
+#include "LinearProbeHashSet.hpp"
+#include "../hash/fmix64.hpp"
+
+namespace hashset {
+
+using std::vector;
+
+// bulk operations over any sets with find and
+// for_each(f, part, parts): every thread walks its own
+// slot range of the iterated set, collects what it
+// found, result is reserved once and filled in order,
+// finds run concurrently, so sets must allow that,
+// HASHSET_STATS counters are atomic for it,
+// threads of 0 are taken as 1
+namespace algebra {
+
+template<typename T>
+T key_of(const IHashSet<T>&);
+
+template<class Set>
+using key_t = decltype(key_of(std::declval<const Set&>()));
+
+inline size_t default_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// fn(part) for every part, first one on the calling thread
+template<class F>
+void parallel(size_t parts, F fn) {
+    parts = std::max<size_t>(parts, 1);
+
+    vector<std::thread> workers;
+    workers.reserve(parts - 1);
+    for (size_t part = 1; part < parts; ++part)
+        workers.emplace_back(fn, part);
+
+    fn(0);
+    for (auto& worker: workers)
+        worker.join();
+}
+
+template<typename T>
+vector<T> concat(vector<vector<T>>& parts) {
+    size_t total = 0;
+    for (const auto& part: parts)
+        total += part.size();
+
+    vector<T> out;
+    out.reserve(total);
+    for (auto& part: parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(out));
+        vector<T>().swap(part);
+    }
+
+    return out;
+}
+
+// keys of set that keep returns true for
+template<class Set, class Keep>
+vector<key_t<Set>> select(const Set& set, Keep keep, size_t threads) {
+    using T = key_t<Set>;
+
+    threads = std::max<size_t>(threads, 1);
+    vector<vector<T>> found(threads);
+    parallel(threads, [&](size_t part) {
+        set.for_each([&](const T& val) {
+            if (keep(val)) found[part].push_back(val);
+        }, part, threads);
+    });
+
+    return concat(found);
+}
+
+template<class Set>
+size_t count(const Set& set, size_t threads) {
+    using T = key_t<Set>;
+
+    threads = std::max<size_t>(threads, 1);
+    vector<size_t> counts(threads, 0);
+    parallel(threads, [&](size_t part) {
+        size_t n = 0;
+        set.for_each([&](const T&) { ++n; }, part, threads);
+        counts[part] = n;
+    });
+
+    size_t total = 0;
+    for (size_t n: counts) total += n;
+    return total;
+}
+
+} // namespace algebra
+
+// keys found in both sets, smaller one by size() is walked
+template<class A, class B>
+vector<algebra::key_t<A>> intersect(const A& a, const B& b,
+        size_t threads=algebra::default_threads()) {
+    using T = algebra::key_t<A>;
+
+    if (a.size() <= b.size())
+        return algebra::select(a, [&](const T& val) { return b.find(val); }, threads);
+
+    return algebra::select(b, [&](const T& val) { return a.find(val); }, threads);
+}
+
+// keys of a not found in b
+template<class A, class B>
+vector<algebra::key_t<A>> difference(const A& a, const B& b,
+        size_t threads=algebra::default_threads()) {
+    using T = algebra::key_t<A>;
+
+    return algebra::select(a, [&](const T& val) { return !b.find(val); }, threads);
+}
+
+// adds keys of b missing from a, they are looked up in
+// parallel and inserted by one thread, returns how many
+template<class A, class B>
+size_t union_with(A& a, const B& b, size_t threads=algebra::default_threads()) {
+    size_t added = 0;
+    for (const auto& val: difference(b, a, threads))
+        added += a.insert(val);
+
+    return added;
+}
+
+// unique keys of random access range, not in their
+// order: keys are split by hash to parts and each part
+// is deduplicated by its own thread in its own Set,
+// integers are mixed by default, identity std::hash
+// would cluster strided keys in linear probing
+template<class It,
+         class Hash=std::conditional_t<
+             std::is_integral_v<typename std::iterator_traits<It>::value_type>,
+             fmix64hash<size_t>,
+             std::hash<typename std::iterator_traits<It>::value_type>>,
+         class Set=LinearProbeHashSet<typename std::iterator_traits<It>::value_type, Hash>>
+vector<typename std::iterator_traits<It>::value_type> dedup(It first, It last,
+        size_t threads=algebra::default_threads()) {
+    using T = typename std::iterator_traits<It>::value_type;
+
+    const size_t n = std::distance(first, last);
+    threads = std::max<size_t>(1, std::min(threads, n / 1024));
+
+    // bins[chunk][part] are positions of chunk keys going to part
+    vector<vector<vector<size_t>>> bins(threads, vector<vector<size_t>>(threads));
+    algebra::parallel(threads, [&](size_t chunk) {
+        const Hash hash{};
+        const auto [from, to] = part_bounds(n, chunk, threads);
+
+        It it = std::next(first, from);
+        for (size_t i = from; i < to; ++i, ++it) {
+            const uint64_t h = hash(*it) * 0x9e3779b97f4a7c15ULL;
+            bins[chunk][(unsigned __int128)(h) * threads >> 64].push_back(i);
+        }
+    });
+
+    vector<vector<T>> found(threads);
+    algebra::parallel(threads, [&](size_t part) {
+        Set seen;
+        for (size_t chunk = 0; chunk < threads; ++chunk) {
+            for (size_t i: bins[chunk][part]) {
+                const T& val = *std::next(first, i);
+                if (seen.insert(val)) found[part].push_back(val);
+            }
+            vector<size_t>().swap(bins[chunk][part]);
+        }
+    });
+
+    return algebra::concat(found);
+}
+
+} // namespace hashset
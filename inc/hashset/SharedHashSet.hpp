@@ -0,0 +1,571 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "IHashSet.hpp"
+
+namespace hashset {
+
+using std::string;
+using std::vector;
+
+// string set living in one shared memory segment or mapped
+// file: header, two linear probing tables and two key arenas,
+// all references are offsets, so every process maps it anywhere,
+// writers take a robust process-shared mutex, readers take
+// no lock and retry when a write overlapped them (seqlock),
+// one table and arena pair is active, the other is spare
+// for compaction, all processes should use the same Hash
+template<class Hash=std::hash<string>>
+class SharedHashSet : public IHashSet<string> {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "Shared set needs lock-free 64 bit atomics");
+
+    static constexpr uint64_t magic = 0x5445534445524853ULL;
+    static constexpr double factor = 0.75;
+    static constexpr size_t min_slots = 16;
+    static constexpr size_t len_bits = 24;
+    static constexpr uint64_t len_mask = (uint64_t(1) << len_bits) - 1;
+    static constexpr size_t npos = size_t(-1);
+    // reader spins on odd seq before it waits for the lock
+    static constexpr size_t max_spins = 1 << 12;
+
+    enum : uint64_t {
+        EMPTY = 0,
+        TOMBSTONE = 1
+    };
+
+    struct Slot {
+        // hash of the key moved off EMPTY and TOMBSTONE
+        std::atomic<uint64_t> tag;
+        // arena offset in high bits, length in low 24 bits
+        std::atomic<uint64_t> ref;
+    };
+
+    struct Header {
+        std::atomic<uint64_t> magic;
+        uint64_t slots;
+        // bytes of one arena
+        uint64_t arena;
+        // populated slots allowed
+        uint64_t limit;
+        pthread_mutex_t lock;
+        // odd while a write is in progress
+        std::atomic<uint64_t> seq;
+        // table and arena readers and writers use, 0 or 1
+        std::atomic<uint64_t> active;
+        std::atomic<uint64_t> size;
+        std::atomic<uint64_t> populated;
+        // active arena bytes taken, only compaction frees them
+        std::atomic<uint64_t> used;
+    };
+
+    // holds the writer lock, the state left by
+    // a writer that died holding it is repaired
+    class Guard {
+        SharedHashSet& set;
+
+    public:
+        Guard(const SharedHashSet& set) : set(const_cast<SharedHashSet&>(set)) {
+            const int rc = pthread_mutex_lock(&set.header().lock);
+            if (rc == EOWNERDEAD) {
+                this->set.recover();
+                pthread_mutex_consistent(&set.header().lock);
+            } else if (rc) {
+                throw std::system_error(rc, std::generic_category(), "Can't lock shared set");
+            }
+        }
+
+        ~Guard() {
+            pthread_mutex_unlock(&set.header().lock);
+        }
+    };
+
+    Hash hash;
+
+    char* base = nullptr;
+    size_t bytes = 0;
+
+    inline Header& header() const {
+        return *reinterpret_cast<Header*>(base);
+    }
+
+    static constexpr size_t table_offset() {
+        return (sizeof(Header) + 63) & ~size_t(63);
+    }
+
+    static constexpr size_t arena_offset(size_t slots) {
+        return table_offset() + 2 * slots * sizeof(Slot);
+    }
+
+    inline Slot* table(uint64_t which) const {
+        return reinterpret_cast<Slot*>(base + table_offset()) + which * header().slots;
+    }
+
+    inline Slot* table() const {
+        return table(header().active.load(std::memory_order_acquire));
+    }
+
+    static constexpr size_t segment_length(size_t slots, size_t arena) {
+        return arena_offset(slots) + 2 * arena;
+    }
+
+    inline char* arena(uint64_t which) const {
+        return base + arena_offset(header().slots) + which * header().arena;
+    }
+
+    inline char* arena() const {
+        return arena(header().active.load(std::memory_order_acquire));
+    }
+
+    inline uint64_t tag_of(const string& val) const {
+        const uint64_t h = hash(val);
+        return h > TOMBSTONE ? h : h + 2;
+    }
+
+    // arena bytes behind ref only change once a later
+    // compaction reuses the arena, seq tells readers so
+    inline bool equal(const char* arena, uint64_t ref, const string& val) const {
+        const uint64_t off = ref >> len_bits, len = ref & len_mask;
+        return len == val.size() && off + len <= header().arena &&
+            std::memcmp(arena + off, val.data(), len) == 0;
+    }
+
+    // table and arena come from one load of active
+    bool probe(const string& val, uint64_t tag) const {
+        const uint64_t active = header().active.load(std::memory_order_acquire);
+        const Slot* slots = table(active);
+        const char* keys = arena(active);
+        const size_t mask = header().slots - 1;
+
+        for (size_t i = 0, id = tag & mask; i <= mask; ++i, id = (id + 1) & mask) {
+            const uint64_t t = slots[id].tag.load(std::memory_order_acquire);
+            if (t == EMPTY) return false;
+            if (t != tag) continue;
+
+            if (equal(keys, slots[id].ref.load(std::memory_order_acquire), val))
+                return true;
+        }
+
+        return false;
+    }
+
+    // writer side, slot of val or npos and
+    // first reusable slot on its way in free
+    size_t locate(const string& val, uint64_t tag, size_t& free) const {
+        const Slot* slots = table();
+        const char* keys = arena();
+        const size_t mask = header().slots - 1;
+        free = npos;
+
+        for (size_t i = 0, id = tag & mask; i <= mask; ++i, id = (id + 1) & mask) {
+            const uint64_t t = slots[id].tag.load(std::memory_order_relaxed);
+            if (t == EMPTY) {
+                if (free == npos) free = id;
+                break;
+            }
+            if (t == TOMBSTONE) {
+                if (free == npos) free = id;
+                continue;
+            }
+            if (t == tag && equal(keys, slots[id].ref.load(std::memory_order_relaxed), val))
+                return id;
+        }
+
+        return npos;
+    }
+
+    inline void begin_write() {
+        Header& hd = header();
+        hd.seq.store(hd.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    inline void end_write() {
+        Header& hd = header();
+        hd.seq.store(hd.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // copies live keys and their bytes to the spare table
+    // and arena and makes them active with one store, so a
+    // writer dying halfway leaves the active pair untouched,
+    // readers still walking the old one see seq move and retry
+    void compact() {
+        Header& hd = header();
+        const uint64_t active = hd.active.load(std::memory_order_relaxed);
+        const Slot* slots = table(active);
+        const char* keys = arena(active);
+        Slot* spare = table(active ^ 1);
+        char* spare_keys = arena(active ^ 1);
+        const size_t n = hd.slots, mask = n - 1;
+
+        for (size_t id = 0; id < n; ++id)
+            spare[id].tag.store(EMPTY, std::memory_order_relaxed);
+
+        size_t live = 0;
+        uint64_t used = 0;
+        for (size_t id = 0; id < n; ++id) {
+            const uint64_t tag = slots[id].tag.load(std::memory_order_relaxed);
+            if (tag <= TOMBSTONE) continue;
+
+            const uint64_t ref = slots[id].ref.load(std::memory_order_relaxed);
+            const uint64_t len = ref & len_mask;
+            std::memcpy(spare_keys + used, keys + (ref >> len_bits), len);
+
+            size_t to = tag & mask;
+            while (spare[to].tag.load(std::memory_order_relaxed) != EMPTY)
+                to = (to + 1) & mask;
+            spare[to].ref.store(used << len_bits | len, std::memory_order_relaxed);
+            spare[to].tag.store(tag, std::memory_order_relaxed);
+
+            used += len;
+            ++live;
+        }
+
+        // used goes after active, a writer dying between
+        // them leaves it too high, which only wastes bytes
+        begin_write();
+        hd.active.store(active ^ 1, std::memory_order_release);
+        hd.populated.store(live, std::memory_order_relaxed);
+        hd.used.store(used, std::memory_order_relaxed);
+        end_write();
+    }
+
+    // counters are recounted, inserts, removes and
+    // compaction publish with single stores, so the
+    // active table is always consistent
+    void recover() {
+        Header& hd = header();
+        const Slot* slots = table();
+
+        size_t size = 0, populated = 0;
+        for (size_t id = 0; id < hd.slots; ++id) {
+            const uint64_t t = slots[id].tag.load(std::memory_order_relaxed);
+            populated += t != EMPTY;
+            size += t > TOMBSTONE;
+        }
+
+        hd.size.store(size, std::memory_order_relaxed);
+        hd.populated.store(populated, std::memory_order_relaxed);
+        if (hd.seq.load(std::memory_order_relaxed) & 1)
+            end_write();
+    }
+
+    static inline void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    static bool is_shm(const string& name) {
+        return name.size() > 1 && name[0] == '/' && name.find('/', 1) == string::npos;
+    }
+
+    // "/name" is a shared memory segment, anything else is a file
+    static int open_fd(const string& name, int flags) {
+        const int fd = is_shm(name) ?
+            shm_open(name.c_str(), flags, 0600) :
+            ::open(name.c_str(), flags, 0600);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Can't open " + name);
+
+        return fd;
+    }
+
+    void map(int fd, size_t length) {
+        void* addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "Can't map shared set");
+
+        base = static_cast<char*>(addr);
+        bytes = length;
+    }
+
+    static size_t slots_for(size_t keys) {
+        size_t slots = min_slots;
+        while (slots * factor < keys) slots *= 2;
+        return slots;
+    }
+
+    // mapping should be zeroed, so all slots are EMPTY
+    void init(size_t slots, size_t arena) {
+        Header* hd = new (base) Header;
+        hd->slots = slots;
+        hd->arena = arena;
+        hd->limit = slots * factor;
+        hd->seq.store(0, std::memory_order_relaxed);
+        hd->active.store(0, std::memory_order_relaxed);
+        hd->size.store(0, std::memory_order_relaxed);
+        hd->populated.store(0, std::memory_order_relaxed);
+        hd->used.store(0, std::memory_order_relaxed);
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&hd->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+
+        // readers attaching earlier see no magic and fail
+        hd->magic.store(magic, std::memory_order_release);
+    }
+
+    struct Unmapped {};
+    SharedHashSet(Unmapped) {}
+
+public:
+    using hasher = Hash;
+
+    // anonymous segment, shared only with forked children,
+    // arena of 0 means 32 bytes per key, pages are taken
+    // lazily, so big default and spare table and arena
+    // cost nothing until used
+    SharedHashSet(size_t keys=1 << 20, size_t arena=0) {
+        const size_t slots = slots_for(keys);
+        if (!arena) arena = keys * 32;
+
+        const size_t length = segment_length(slots, arena);
+        void* addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "Can't map shared set");
+
+        base = static_cast<char*>(addr);
+        bytes = length;
+        init(slots, arena);
+    }
+
+    SharedHashSet(SharedHashSet&& other) :
+        base(std::exchange(other.base, nullptr)),
+        bytes(std::exchange(other.bytes, 0)) {}
+
+    SharedHashSet& operator=(SharedHashSet&& other) {
+        std::swap(base, other.base);
+        std::swap(bytes, other.bytes);
+        return *this;
+    }
+
+    SharedHashSet(const SharedHashSet&) = delete;
+    SharedHashSet& operator=(const SharedHashSet&) = delete;
+
+    ~SharedHashSet() {
+        if (base) munmap(base, bytes);
+    }
+
+    // new empty set for up to keys keys and arena key bytes,
+    // set with the same name is unlinked, not truncated, so
+    // processes that still map it keep reading the old one
+    static SharedHashSet create(const string& name, size_t keys, size_t arena=0) {
+        const size_t slots = slots_for(keys);
+        if (!arena) arena = keys * 32;
+        const size_t length = segment_length(slots, arena);
+
+        const int rc = is_shm(name) ? shm_unlink(name.c_str()) : ::unlink(name.c_str());
+        if (rc < 0 && errno != ENOENT)
+            throw std::system_error(errno, std::generic_category(), "Can't replace " + name);
+
+        const int fd = open_fd(name, O_RDWR | O_CREAT | O_EXCL);
+        SharedHashSet set{Unmapped{}};
+        try {
+            if (ftruncate(fd, length) < 0)
+                throw std::system_error(errno, std::generic_category(), "Can't resize " + name);
+            set.map(fd, length);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+
+        set.init(slots, arena);
+        return set;
+    }
+
+    // set created by another process
+    static SharedHashSet open(const string& name) {
+        const int fd = open_fd(name, O_RDWR);
+        SharedHashSet set{Unmapped{}};
+        try {
+            struct stat st;
+            if (fstat(fd, &st) < 0)
+                throw std::system_error(errno, std::generic_category(), "Can't stat " + name);
+            if (size_t(st.st_size) < table_offset())
+                throw std::runtime_error("Not a shared set");
+            set.map(fd, st.st_size);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+
+        const Header& hd = set.header();
+        if (hd.magic.load(std::memory_order_acquire) != magic ||
+            segment_length(hd.slots, hd.arena) != set.bytes)
+            throw std::runtime_error("Not a shared set");
+
+        return set;
+    }
+
+    static void unlink(const string& name) {
+        const int rc = is_shm(name) ? shm_unlink(name.c_str()) : ::unlink(name.c_str());
+        if (rc < 0)
+            throw std::system_error(errno, std::generic_category(), "Can't unlink " + name);
+    }
+
+    virtual bool insert(const string& val) override {
+        if (val.size() > len_mask)
+            throw std::length_error("Key is too long for shared set");
+
+        const uint64_t tag = tag_of(val);
+        Guard guard(*this);
+        Header& hd = header();
+
+        size_t free;
+        if (locate(val, tag, free) != npos)
+            return false;
+
+        // compaction drops tombstones and bytes of removed keys
+        Slot* slots = table();
+        const bool crowded = free == npos ||
+            (slots[free].tag.load(std::memory_order_relaxed) == EMPTY &&
+             hd.populated.load(std::memory_order_relaxed) + 1 > hd.limit);
+        if (crowded || hd.used.load(std::memory_order_relaxed) + val.size() > hd.arena) {
+            if (crowded && hd.size.load(std::memory_order_relaxed) + 1 > hd.limit)
+                throw std::length_error("Shared set is full");
+
+            compact();
+            slots = table();
+            locate(val, tag, free);
+        }
+
+        const uint64_t used = hd.used.load(std::memory_order_relaxed);
+        if (used + val.size() > hd.arena || (used + val.size()) >> (64 - len_bits))
+            throw std::length_error("Shared set arena is full");
+
+        // bytes are written before anyone could see them
+        std::memcpy(arena() + used, val.data(), val.size());
+        hd.used.store(used + val.size(), std::memory_order_relaxed);
+
+        begin_write();
+        if (slots[free].tag.load(std::memory_order_relaxed) == EMPTY)
+            hd.populated.fetch_add(1, std::memory_order_relaxed);
+        slots[free].ref.store(used << len_bits | val.size(), std::memory_order_release);
+        slots[free].tag.store(tag, std::memory_order_release);
+        hd.size.fetch_add(1, std::memory_order_relaxed);
+        end_write();
+
+        return true;
+    }
+
+    virtual bool find(const string& val) const override {
+        const uint64_t tag = tag_of(val);
+        const Header& hd = header();
+
+        for (size_t spins = 0;;) {
+            const uint64_t seq = hd.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                if (++spins < max_spins) {
+                    relax();
+                    continue;
+                }
+
+                // writer is slow or dead, the lock waits for a
+                // live one and repairs what a dead one left
+                Guard guard(*this);
+                spins = 0;
+                continue;
+            }
+
+            const bool found = probe(val, tag);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (hd.seq.load(std::memory_order_relaxed) == seq)
+                return found;
+        }
+    }
+
+    // bytes of removed keys stay in arena until compaction
+    virtual bool remove(const string& val) override {
+        const uint64_t tag = tag_of(val);
+        Guard guard(*this);
+
+        size_t free;
+        const size_t id = locate(val, tag, free);
+        if (id == npos)
+            return false;
+
+        begin_write();
+        table()[id].tag.store(TOMBSTONE, std::memory_order_release);
+        header().size.fetch_sub(1, std::memory_order_relaxed);
+        end_write();
+
+        return true;
+    }
+
+    virtual size_t size() const override {
+        return header().size.load(std::memory_order_relaxed);
+    }
+
+    virtual HashSetStats stats() const override {
+        Guard guard(*this);
+        const Header& hd = header();
+        const Slot* slots = table();
+        const size_t mask = hd.slots - 1;
+
+        HashSetStats stats;
+        stats.size = hd.size.load(std::memory_order_relaxed);
+        stats.capacity = hd.slots;
+
+        for (size_t id = 0; id < hd.slots; ++id) {
+            const uint64_t t = slots[id].tag.load(std::memory_order_relaxed);
+            if (t == TOMBSTONE) ++stats.tombstones;
+            if (t > TOMBSTONE) stats.add_probe(((id - (t & mask)) & mask) + 1);
+        }
+
+        return stats.finish();
+    }
+
+    // runs under writer lock, readers are not blocked,
+    // but parts walked by several threads take turns,
+    // f gets a temporary copy of every key
+    template<class F>
+    void for_each(F f, size_t part=0, size_t parts=1) const {
+        Guard guard(*this);
+        const Slot* slots = table();
+
+        const auto [from, to] = part_bounds(header().slots, part, parts);
+        for (size_t id = from; id < to; ++id) {
+            if (slots[id].tag.load(std::memory_order_relaxed) <= TOMBSTONE)
+                continue;
+
+            const uint64_t ref = slots[id].ref.load(std::memory_order_relaxed);
+            f(string(arena() + (ref >> len_bits), ref & len_mask));
+        }
+    }
+
+    size_t segment_bytes() const {
+        return bytes;
+    }
+
+    size_t arena_used() const {
+        return header().used.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace hashset
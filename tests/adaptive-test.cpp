@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <string>
+#include <random>
+#include <numeric>
+#include <unordered_set>
+
+#include "hashset/AdaptiveHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+size_t hashes = 0;
+
+// identity like std::hash, but counted
+struct CountingHash {
+    size_t operator()(size_t val) const {
+        ++hashes;
+        return val;
+    }
+};
+
+template<class Set, class Make>
+void matches(Set& set, Make make, size_t n, bool misses) {
+    unordered_set<decltype(make(0))> ref;
+    mt19937_64 rg(5);
+
+    for (size_t i = 0; i < 4 * n; ++i) {
+        const auto key = make(rg() % n);
+        const size_t op = rg() % 10;
+
+        if (op < 5) CHECK(set.insert(key) == ref.insert(key).second);
+        else if (op < 8) {
+            const auto probe = misses ? make(rg() % n + n) : key;
+            CHECK(set.find(probe) == (ref.count(probe) > 0));
+        } else CHECK(set.remove(key) == (ref.erase(key) > 0));
+    }
+
+    size_t keys = 0;
+    set.for_each([&](const auto& val) {
+        CHECK(ref.count(val));
+        ++keys;
+    });
+    CHECK(keys == ref.size());
+
+    // probe lengths are kept on the way, not rehashed
+    hashes = 0;
+    const auto stats = set.stats();
+    CHECK(hashes == 0);
+    CHECK(stats.size == ref.size());
+    CHECK(accumulate(stats.histogram.begin(), stats.histogram.end(), size_t(0)) == ref.size());
+
+    const Set copy = set;
+    for (const auto& val: ref)
+        CHECK(copy.find(val));
+}
+
+// every key gets the same hash
+struct ConstantHash {
+    size_t operator()(size_t) const {
+        return 42;
+    }
+};
+
+int main() {
+    for (size_t n: {50, 5000, 200000}) {
+        for (bool misses: {false, true}) {
+            AdaptiveHashSet<size_t, CountingHash> ints;
+            matches(ints, [](size_t i) { return i; }, n, misses);
+
+            AdaptiveHashSet<string> strings;
+            matches(strings, [](size_t i) { return to_string(i); }, n, misses);
+        }
+    }
+
+    // strided keys are all the same modulo table size
+    // under identity std::hash, set should still stay dense
+    AdaptiveHashSet<size_t> strided;
+    for (size_t i = 0; i < 200000; ++i)
+        CHECK(strided.insert(i << 20));
+    for (size_t i = 0; i < 200000; ++i)
+        CHECK(strided.find(i << 20));
+    CHECK(strided.stats().load_factor > 0.3);
+
+    // misses push set to cuckoo buckets, but keys sharing
+    // one full hash never fit them, so it falls back to
+    // linear probing instead of growing forever
+    AdaptiveHashSet<size_t, ConstantHash, ConstantHash> same;
+    for (size_t i = 0; i < 3000; ++i) {
+        CHECK(same.insert(i));
+        CHECK(!same.find(i + 1000000));
+        CHECK(!same.find(i + 2000000));
+    }
+    for (size_t i = 0; i < 3000; ++i)
+        CHECK(same.find(i));
+    CHECK(same.mode() == AdaptiveMode::OPEN);
+    CHECK(same.stats().capacity <= 8192);
+}
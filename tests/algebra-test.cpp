@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "hashset/ChainHashSet.hpp"
+#include "hashset/LinearProbeHashSet.hpp"
+#include "hashset/AdaptiveHashSet.hpp"
+#include "hashset/SetAlgebra.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+template<typename T>
+static set<T> sorted(const vector<T>& keys) {
+    const set<T> out(keys.begin(), keys.end());
+    CHECK(out.size() == keys.size());
+    return out;
+}
+
+// a holds multiples of 2, b multiples of 3 below n
+template<class A, class B, class Make>
+void check(size_t n, size_t threads, Make make) {
+    using T = algebra::key_t<A>;
+
+    A a;
+    B b;
+    set<T> both, only_a, either;
+    for (size_t i = 0; i < n; ++i) {
+        const T val = make(i);
+        if (i % 2 == 0) a.insert(val);
+        if (i % 3 == 0) b.insert(val);
+
+        if (i % 6 == 0) both.insert(val);
+        if (i % 2 == 0 && i % 3 != 0) only_a.insert(val);
+        if (i % 2 == 0 || i % 3 == 0) either.insert(val);
+    }
+
+    CHECK(sorted(intersect(a, b, threads)) == both);
+    CHECK(sorted(intersect(b, a, threads)) == both);
+    CHECK(sorted(difference(a, b, threads)) == only_a);
+
+    CHECK(union_with(a, b, threads) == either.size() - n / 2 - n % 2);
+    CHECK(union_with(a, b, threads) == 0);
+    CHECK(algebra::count(a, threads) == either.size());
+    CHECK(a.size() == either.size());
+    CHECK(b.size() == n / 3 + (n % 3 > 0));
+    CHECK(sorted(difference(a, b, threads)) == only_a);
+
+    vector<T> keys;
+    for (size_t i = 0; i < n * 3; ++i)
+        keys.push_back(make(i * 7 % n));
+    CHECK(sorted(dedup(keys.begin(), keys.end(), threads)).size() == n);
+}
+
+int main() {
+    auto number = [](size_t i) { return i; };
+    auto text = [](size_t i) { return "key-" + to_string(i); };
+
+    for (size_t threads: {0, 1, 3, 8}) {
+        for (size_t n: {0, 1, 10, 30000}) {
+            check<LinearProbeHashSet<size_t>, ChainHashSet<size_t>>(n, threads, number);
+            check<ChainHashSet<string>, AdaptiveHashSet<string>>(n, threads, text);
+            check<AdaptiveHashSet<size_t>, AdaptiveHashSet<size_t>>(n, threads, number);
+        }
+    }
+
+    // strided integers would all share a few homes
+    // under identity std::hash, default mixes them
+    vector<size_t> strided;
+    for (size_t i = 0; i < 200000; ++i)
+        strided.push_back((i % 100000) << 20);
+    CHECK(sorted(dedup(strided.begin(), strided.end(), 1)).size() == 100000);
+
+    return 0;
+}
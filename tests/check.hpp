@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// assert that stays in release builds
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ \
+            << ": CHECK(" #cond ") failed" << std::endl; \
+        std::exit(1); \
+    } \
+} while (0)
@@ -0,0 +1,64 @@
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <unordered_set>
+
+#include "hashset/ChainHashSet.hpp"
+#include "hashset/LinearProbeHashSet.hpp"
+#include "hashset/DoubleHashingHashSet.hpp"
+#include "hashset/HopscotchHashSet.hpp"
+#include "hashset/FilteredHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+size_t hashes = 0;
+
+struct CountingHash {
+    size_t operator()(size_t val) const {
+        ++hashes;
+        return std::hash<size_t>{}(val * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+template<class Set>
+void matches(Set& set, bool once) {
+    unordered_set<size_t> ref;
+    mt19937_64 rg(11);
+
+    for (size_t i = 0; i < 100000; ++i) {
+        const size_t key = rg() % 30000;
+        const size_t op = rg() % 4;
+
+        hashes = 0;
+        if (op == 0) CHECK(set.insert(key) == ref.insert(key).second);
+        else if (op == 1) CHECK(set.remove(key) == (ref.erase(key) > 0));
+        else CHECK(set.find(key) == (ref.count(key) > 0));
+
+        // rehash and filter rebuild hash other keys too
+        if (once && op != 0) CHECK(hashes <= 1);
+    }
+}
+
+int main() {
+    FilteredHashSet<size_t, ChainHashSet<size_t, CountingHash>> chain;
+    matches(chain, true);
+
+    FilteredHashSet<size_t, LinearProbeHashSet<size_t, CountingHash>, CuckooFilter> linear(0.5);
+    matches(linear, true);
+
+    FilteredHashSet<size_t, DoubleHashingHashSet<size_t, CountingHash, std::hash<size_t>>> twice;
+    matches(twice, true);
+
+    // inner set without hashed lookups still works
+    FilteredHashSet<size_t, HopscotchHashSet<size_t, CountingHash>> hop;
+    matches(hop, false);
+
+    // copies go to copy constructor, not to inner set
+    FilteredHashSet<size_t, ChainHashSet<size_t>> orig;
+    orig.insert(1);
+    FilteredHashSet<size_t, ChainHashSet<size_t>> copy(orig);
+    CHECK(copy.find(1));
+}
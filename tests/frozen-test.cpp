@@ -0,0 +1,70 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include "hashset/ChainHashSet.hpp"
+#include "hashset/FrozenHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+template<typename T, class Make>
+void roundtrip(Make make) {
+    ChainHashSet<T> source;
+    for (size_t i = 0; i < 20000; ++i)
+        source.insert(make(i));
+
+    // string frozen set passes keys to for_each by value
+    const auto first = FrozenHashSet<T>::from(source);
+    const auto frozen = FrozenHashSet<T>::from(first);
+    for (size_t i = 0; i < 20000; ++i)
+        CHECK(frozen.find(make(i)));
+    for (size_t i = 20000; i < 40000; ++i)
+        CHECK(!frozen.find(make(i)));
+
+    size_t keys = 0;
+    frozen.for_each([&](const T& val) {
+        CHECK(source.find(val));
+        ++keys;
+    });
+    CHECK(keys == 20000);
+
+    stringstream out;
+    frozen.save(out);
+    const string bytes = out.str();
+
+    stringstream in(bytes);
+    const auto loaded = FrozenHashSet<T>::load(in);
+    for (size_t i = 0; i < 20000; ++i)
+        CHECK(loaded.find(make(i)));
+
+    // every truncation is rejected
+    for (size_t len: {size_t(0), size_t(20), size_t(48), bytes.size() / 2, bytes.size() - 1}) {
+        stringstream cut(bytes.substr(0, len));
+        bool thrown = false;
+        try { FrozenHashSet<T>::load(cut); } catch (const std::runtime_error&) { thrown = true; }
+        CHECK(thrown);
+    }
+
+    // header fields and remap entries out of range
+    const size_t remap_at = 6 * sizeof(uint64_t) + (20000 / 4 + 1) * sizeof(uint16_t);
+    for (size_t at: {size_t(16), size_t(24), size_t(32), remap_at}) {
+        string bad = bytes;
+        const uint32_t garbage = 0xfffffff0;
+        bad.replace(at, sizeof(garbage), (const char*)&garbage, sizeof(garbage));
+
+        stringstream broken(bad);
+        bool thrown = false;
+        try { FrozenHashSet<T>::load(broken); } catch (const std::runtime_error&) { thrown = true; }
+        CHECK(thrown);
+    }
+}
+
+int main() {
+    roundtrip<string>([](size_t i) { return "key" + to_string(i); });
+    roundtrip<size_t>([](size_t i) { return i * 7919; });
+}
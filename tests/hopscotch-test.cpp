@@ -0,0 +1,123 @@
+#include <cstddef>
+#include <random>
+#include <vector>
+#include <unordered_set>
+
+// displacements are only counted with stats on
+#ifndef HASHSET_STATS
+#define HASHSET_STATS
+#endif
+
+#include "hashset/HopscotchHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+// four keys share every home and homes are 5 slots
+// apart, so the range they cover is 0.8 full
+struct CrowdHash {
+    size_t operator()(size_t val) const {
+        return val / 4 * 5;
+    }
+};
+
+template<class Set>
+void same(const Set& set, const unordered_set<size_t>& ref) {
+    CHECK(set.stats().size == ref.size());
+    for (const size_t key: ref)
+        CHECK(set.find(key));
+
+    size_t keys = 0;
+    set.for_each([&](size_t key) { CHECK(ref.count(key)); ++keys; });
+    CHECK(keys == ref.size());
+}
+
+// fills to load without growing and churns there
+template<size_t H>
+void loaded(double load) {
+    HopscotchHashSet<size_t, std::hash<size_t>, H> set;
+    unordered_set<size_t> ref;
+    mt19937_64 rg(H);
+
+    const size_t n = (1 << 16) * load;
+    vector<size_t> keys;
+    while (ref.size() < n) {
+        const size_t key = rg();
+        CHECK(set.insert(key) == ref.insert(key).second);
+        keys.push_back(key);
+    }
+    CHECK(!set.insert(keys.front()));
+    CHECK(set.stats().capacity == 1 << 16);
+    same(set, ref);
+
+    for (size_t i = 0; i < 200000; ++i) {
+        const size_t key = rg() % 2 ? keys[rg() % keys.size()] : rg();
+        if (ref.size() >= n) CHECK(set.remove(key) == (ref.erase(key) > 0));
+        else if (rg() % 2) CHECK(set.insert(key) == ref.insert(key).second);
+        else CHECK(set.remove(key) == (ref.erase(key) > 0));
+        CHECK(set.find(key) == (ref.count(key) > 0));
+    }
+    same(set, ref);
+
+    CHECK(set.stats().max_probe <= H);
+}
+
+// crowded homes need hops, neighborhood still holds all keys
+template<size_t H>
+void crowded() {
+    HopscotchHashSet<size_t, CrowdHash, H> set;
+    unordered_set<size_t> ref;
+
+    for (size_t i = 0; i < 20000; ++i) {
+        CHECK(set.insert(i));
+        ref.insert(i);
+    }
+    for (size_t i = 0; i < 20000; i += 3) {
+        CHECK(set.remove(i));
+        CHECK(!set.remove(i));
+        ref.erase(i);
+    }
+    for (size_t i = 0; i < 20000; i += 6) {
+        CHECK(set.insert(i));
+        ref.insert(i);
+    }
+    same(set, ref);
+
+    const auto stats = set.stats();
+    CHECK(stats.displacements > 0);
+    CHECK(stats.max_probe <= H);
+}
+
+// more than H keys share home until table is large
+// enough to split them, so place fails and set grows
+// past what load factor asks for
+template<size_t H>
+void overflow() {
+    HopscotchHashSet<size_t, std::hash<size_t>, H> set;
+    unordered_set<size_t> ref;
+
+    for (size_t i = 0; i < 4 * H; ++i) {
+        CHECK(set.insert(i << 10));
+        ref.insert(i << 10);
+    }
+    same(set, ref);
+
+    const auto stats = set.stats();
+    CHECK(stats.capacity >= 4096);
+    CHECK(stats.load_factor < 0.1);
+    CHECK(stats.max_probe <= H);
+}
+
+int main() {
+    // smaller neighborhood runs out of hops sooner
+    loaded<32>(0.82);
+    loaded<64>(0.89);
+    crowded<32>();
+    crowded<64>();
+    overflow<32>();
+    overflow<64>();
+
+    return 0;
+}
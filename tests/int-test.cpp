@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <random>
+#include <numeric>
+#include <unordered_set>
+
+#include "hashset/IntHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+size_t hashes = 0;
+
+struct CountingHash {
+    size_t operator()(uint64_t val) const {
+        ++hashes;
+        return fmix64hash<size_t>{}(val);
+    }
+};
+
+template<class Set>
+void same(const Set& set, const unordered_set<uint64_t>& ref) {
+    for (const uint64_t key: ref)
+        CHECK(set.find(key));
+
+    size_t keys = 0;
+    set.for_each([&](uint64_t key) { CHECK(ref.count(key)); ++keys; });
+    CHECK(keys == ref.size());
+
+    hashes = 0;
+    const auto stats = set.stats();
+    CHECK(hashes == 0);
+    CHECK(stats.size == ref.size());
+    CHECK(accumulate(stats.histogram.begin(), stats.histogram.end(), size_t(0)) == ref.size());
+}
+
+// small universe with 0 and 1 in it, so special
+// keys and tombstones are hit all the time
+void matches() {
+    IntHashSet<CountingHash> set;
+    unordered_set<uint64_t> ref;
+    mt19937_64 rg(5);
+
+    for (size_t i = 0; i < 300000; ++i) {
+        const uint64_t key = rg() % 20000;
+        const size_t op = rg() % 4;
+
+        if (op == 0) CHECK(set.insert(key) == ref.insert(key).second);
+        else if (op == 1) CHECK(set.remove(key) == (ref.erase(key) > 0));
+        else CHECK(set.find(key) == (ref.count(key) > 0));
+
+        if (i % 50000 == 0) same(set, ref);
+    }
+    same(set, ref);
+}
+
+void special() {
+    IntHashSet<> set;
+    for (const uint64_t key: {0, 1}) {
+        CHECK(!set.find(key));
+        CHECK(set.insert(key));
+        CHECK(!set.insert(key));
+        CHECK(set.find(key));
+    }
+    CHECK(set.stats().size == 2);
+    CHECK(set.stats().load_factor == 0);
+
+    CHECK(set.remove(0));
+    CHECK(!set.remove(0));
+    CHECK(!set.find(0));
+    CHECK(set.find(1));
+    CHECK(set.stats().size == 1);
+}
+
+// removed slots are reused, so churn of the same
+// size neither grows the table nor piles tombstones
+void reuse() {
+    IntHashSet<> set;
+    for (uint64_t key = 2; key < 1002; ++key)
+        CHECK(set.insert(key));
+    const size_t capacity = set.stats().capacity;
+
+    for (uint64_t key = 2; key < 1002; ++key) {
+        CHECK(set.remove(key));
+        CHECK(set.insert(key));
+    }
+    CHECK(set.stats().tombstones == 0);
+    CHECK(set.stats().capacity == capacity);
+
+    for (uint64_t key = 2; key < 502; ++key)
+        CHECK(set.remove(key));
+    CHECK(set.stats().tombstones == 500);
+    for (uint64_t key = 2; key < 502; ++key)
+        CHECK(set.insert(key));
+    CHECK(set.stats().tombstones == 0);
+    CHECK(set.stats().capacity == capacity);
+}
+
+void resize() {
+    IntHashSet<> set;
+    unordered_set<uint64_t> ref;
+    mt19937_64 rg(9);
+    for (size_t i = 0; i < 100000; ++i) {
+        const uint64_t key = rg();
+        CHECK(set.insert(key) == ref.insert(key).second);
+    }
+    same(set, ref);
+
+    const auto stats = set.stats();
+    CHECK(stats.capacity >= ref.size() / 0.8);
+    CHECK(stats.rehashes > 0);
+}
+
+// factor of 1 and above is clamped, table never fills up
+void full() {
+    for (const double factor: {1.0, 1.5}) {
+        IntHashSet<> set(factor);
+        for (uint64_t key = 2; key < 20000; ++key)
+            CHECK(set.insert(key));
+        for (uint64_t key = 2; key < 20000; ++key)
+            CHECK(set.find(key));
+        CHECK(!set.find(20000));
+        CHECK(set.stats().load_factor < 1);
+    }
+}
+
+int main() {
+    matches();
+    special();
+    reuse();
+    resize();
+    full();
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <system_error>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "hashset/SharedHashSet.hpp"
+#include "hashset/FrozenHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+static const size_t stable = 500;
+
+static string key(size_t i) {
+    return "key-" + to_string(i);
+}
+
+// inserts and removes keys past stable ones, so
+// tombstones pile up and compaction runs often
+static void churn(SharedHashSet<>& set, size_t round) {
+    for (size_t i = 0; i < 100; ++i)
+        set.insert(key(stable + round * 100 + i));
+    for (size_t i = 0; i < 100; ++i)
+        set.remove(key(stable + round * 100 + i));
+}
+
+static bool all_stable(const SharedHashSet<>& set) {
+    for (size_t i = 0; i < stable; ++i)
+        if (!set.find(key(i))) return false;
+    return true;
+}
+
+// children read while parent writes
+static void readers(size_t children) {
+    SharedHashSet<> set(1000, 1 << 28);
+    for (size_t i = 0; i < stable; ++i)
+        CHECK(set.insert(key(i)));
+
+    vector<pid_t> pids;
+    for (size_t child = 0; child < children; ++child) {
+        const pid_t pid = fork();
+        CHECK(pid >= 0);
+        if (pid == 0) {
+            bool ok = true;
+            for (size_t round = 0; round < 200; ++round)
+                ok = ok && all_stable(set) && !set.find(key(1 << 30));
+            _exit(ok ? 0 : 1);
+        }
+        pids.push_back(pid);
+    }
+
+    size_t round = 0, running = children;
+    while (running) {
+        churn(set, round++);
+        for (pid_t& pid: pids) {
+            int status;
+            if (pid && waitpid(pid, &status, WNOHANG) == pid) {
+                CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                pid = 0;
+                --running;
+            }
+        }
+    }
+
+    CHECK(set.stats().size == stable);
+}
+
+// writer is killed at random moments, maybe inside a
+// write or compaction, parent must neither hang nor lose keys
+static void dead_writer(size_t kills) {
+    SharedHashSet<> set(1000, 1 << 28);
+    for (size_t i = 0; i < stable; ++i)
+        CHECK(set.insert(key(i)));
+
+    for (size_t kill = 0; kill < kills; ++kill) {
+        const pid_t pid = fork();
+        CHECK(pid >= 0);
+        if (pid == 0) {
+            // keys left by killed writers stay few
+            for (size_t round = 0;; ++round)
+                churn(set, round % 5);
+        }
+
+        this_thread::sleep_for(chrono::microseconds(500 + kill * 137 % 2000));
+        CHECK(::kill(pid, SIGKILL) == 0);
+        int status;
+        CHECK(waitpid(pid, &status, 0) == pid);
+
+        CHECK(all_stable(set));
+        CHECK(set.insert(key(1 << 30)));
+        CHECK(set.remove(key(1 << 30)));
+    }
+
+    size_t keys = 0;
+    set.for_each([&](const string&) { ++keys; });
+    CHECK(keys == set.stats().size);
+    CHECK(keys >= stable);
+}
+
+// segment by name seen from two mappings and a child,
+// create replaces it without touching old mappings
+static void named(const string& name) {
+    auto set = SharedHashSet<>::create(name, 1000);
+    CHECK(set.insert("first"));
+
+    auto other = SharedHashSet<>::open(name);
+    CHECK(other.find("first"));
+    CHECK(other.insert("second"));
+    CHECK(set.find("second"));
+
+    const pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        auto child = SharedHashSet<>::open(name);
+        _exit(child.find("second") && child.insert("child") ? 0 : 1);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(set.find("child"));
+
+    auto fresh = SharedHashSet<>::create(name, 10);
+    CHECK(!fresh.find("first"));
+    CHECK(set.find("first") && other.find("child"));
+    CHECK(set.insert("third"));
+    CHECK(!SharedHashSet<>::open(name).find("third"));
+    CHECK(SharedHashSet<>::open(name).segment_bytes() == fresh.segment_bytes());
+
+    SharedHashSet<>::unlink(name);
+    bool opened = true;
+    try {
+        SharedHashSet<>::open(name);
+    } catch (const std::system_error&) {
+        opened = false;
+    }
+    CHECK(!opened);
+}
+
+// bytes of removed keys come back on compaction,
+// only live keys can fill the arena
+static void arena() {
+    SharedHashSet<> set(1000, 4096);
+    for (size_t i = 0; i < 100000; ++i) {
+        CHECK(set.insert(key(i)));
+        CHECK(set.find(key(i)));
+        CHECK(set.remove(key(i)));
+    }
+    CHECK(set.arena_used() <= 4096);
+
+    size_t kept = 0;
+    try {
+        for (;; ++kept)
+            set.insert(key(kept));
+    } catch (const std::length_error&) {}
+    CHECK(set.arena_used() <= 4096);
+    CHECK(set.arena_used() + key(kept).size() > 4096);
+    for (size_t i = 0; i < kept; ++i)
+        CHECK(set.find(key(i)));
+}
+
+// for_each hands out temporaries, frozen set must copy them
+static void frozen() {
+    SharedHashSet<> set(5000);
+    for (size_t i = 0; i < 5000; ++i)
+        CHECK(set.insert(key(i)));
+
+    const auto frozen = FrozenHashSet<string>::from(set);
+    for (size_t i = 0; i < 5000; ++i)
+        CHECK(frozen.find(key(i)));
+    CHECK(!frozen.find(key(5000)));
+}
+
+int main() {
+    readers(4);
+    dead_writer(20);
+    named("/hashset-test-" + to_string(getpid()));
+    named("hashset-test-" + to_string(getpid()) + ".bin");
+    arena();
+    frozen();
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <unordered_set>
+
+#include "hashset/LinearProbeHashSet.hpp"
+#include "hashset/QuadraticProbeHashSet.hpp"
+#include "hashset/DoubleHashingHashSet.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace hashset;
+
+size_t hashes = 0;
+
+// counts calls to see what stats cost
+struct CountingHash {
+    size_t operator()(size_t val) const {
+        ++hashes;
+        return std::hash<size_t>{}(val * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+template<class Set>
+void incremental() {
+    Set set;
+    unordered_set<size_t> ref;
+    size_t tombstones = 0;
+    mt19937_64 rg(7);
+
+    for (size_t i = 0; i < 50000; ++i) {
+        const size_t key = rg() % 20000;
+        if (rg() % 3) {
+            CHECK(set.insert(key) == ref.insert(key).second);
+        } else {
+            CHECK(set.remove(key) == (ref.erase(key) > 0));
+        }
+
+        if (i % 5000) continue;
+
+        hashes = 0;
+        const HashSetStats stats = set.stats();
+        CHECK(hashes == 0);
+
+        CHECK(stats.size == ref.size());
+        size_t keys = 0;
+        for (size_t n: stats.histogram) keys += n;
+        CHECK(keys == ref.size());
+        CHECK(stats.max_probe == stats.histogram.size());
+        CHECK(stats.histogram.empty() || stats.histogram.back() > 0);
+        CHECK(stats.load_factor <= 1);
+        tombstones += stats.tombstones;
+    }
+
+    CHECK(tombstones > 0);
+}
+
+int main() {
+    incremental<LinearProbeHashSet<size_t, CountingHash>>();
+    incremental<QuadraticProbeHashSet<size_t, CountingHash>>();
+    incremental<DoubleHashingHashSet<size_t, CountingHash, CountingHash>>();
+}
@@ -0,0 +1,60 @@
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "bench/Workload.hpp"
+
+#include "check.hpp"
+
+using namespace std;
+using namespace bench;
+
+template<typename T>
+bool same(const Workload<T>& a, const Workload<T>& b) {
+    if (a.keys != b.keys || a.preload != b.preload || a.ops.size() != b.ops.size())
+        return false;
+
+    for (size_t i = 0; i < a.ops.size(); ++i)
+        if (a.ops[i].type != b.ops[i].type || a.ops[i].key != b.ops[i].key)
+            return false;
+
+    return true;
+}
+
+template<typename T>
+void deterministic(WorkloadConfig cfg, const vector<T>& source = {}) {
+    const auto first = generate<T>(cfg, source);
+    CHECK(same(first, generate<T>(cfg, source)));
+    CHECK(first.preload.size() == cfg.preload);
+    CHECK(first.ops.size() == cfg.ops);
+    for (const auto& op: first.ops)
+        CHECK(op.key < first.keys.size());
+
+    ++cfg.seed;
+    CHECK(!same(first, generate<T>(cfg, source)));
+}
+
+int main() {
+    WorkloadConfig cfg;
+    cfg.seed = 42;
+    cfg.preload = 5000;
+    cfg.ops = 20000;
+    cfg.insert_ratio = 0.2;
+
+    for (const auto dist: {KeyDist::UNIFORM, KeyDist::ZIPF, KeyDist::HOTSPOT}) {
+        cfg.dist = dist;
+        deterministic<size_t>(cfg);
+        deterministic<string>(cfg);
+
+        vector<string> words;
+        for (size_t i = 0; i < 20000; ++i)
+            words.push_back("w" + to_string(i));
+        deterministic<string>(cfg, words);
+    }
+
+    // one character keys allow only 62 distinct ones
+    cfg.length = LengthDist::FIXED;
+    const auto wl = generate<string>(cfg);
+    CHECK(unordered_set<string>(wl.keys.begin(), wl.keys.end()).size() == wl.keys.size());
+    deterministic<string>(cfg);
+}